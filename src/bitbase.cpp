@@ -0,0 +1,133 @@
+#include "bitbase.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+#include "bitboards.hpp"
+#include "utils.hpp"
+
+namespace Spotlight {
+
+static U64 kpk_bits[KPK_POSITIONS / 64];
+
+// bit 0-5 white king, 6-11 black king, 12 side to move, 13-14 pawn file, 15-17 pawn rank - 1
+static inline int kpkIndex(Square white_king, Square white_pawn, Square black_king,
+                           Color side_to_move) {
+    return white_king | (black_king << 6) | (side_to_move << 12) | ((white_pawn % 8) << 13) |
+           ((white_pawn / 8 - 1) << 15);
+}
+
+// results are flags so the successors of a position can be or'ed together
+enum KPKResult : uint8_t { KPK_INVALID = 0, KPK_UNKNOWN = 1, KPK_DRAW = 2, KPK_WIN = 4 };
+
+struct KPKPosition {
+    Square kings[2];
+    Square pawn;
+    Color side_to_move;
+    uint8_t result;
+};
+
+static inline int kingDistance(Square a, Square b) {
+    return std::max(std::abs(a % 8 - b % 8), std::abs(a / 8 - b / 8));
+}
+
+// the outcome where it follows from the position alone, otherwise KPK_UNKNOWN
+static uint8_t initialResult(const KPKPosition &pos) {
+    Square white_king = pos.kings[WHITE];
+    Square black_king = pos.kings[BLACK];
+    Square pawn = pos.pawn;
+
+    if (kingDistance(white_king, black_king) <= 1 || white_king == pawn || black_king == pawn ||
+        (pos.side_to_move == WHITE && (pawn_attacks[WHITE][pawn] & setBit(black_king)))) {
+        return KPK_INVALID;
+    }
+
+    if (pos.side_to_move == WHITE) {
+        // the pawn promotes and the new queen can't be taken
+        Square promotion = static_cast<Square>(pawn + 8);
+        if (pawn / 8 == 6 && white_king != promotion &&
+            (kingDistance(black_king, promotion) > 1 || kingDistance(white_king, promotion) == 1)) {
+            return KPK_WIN;
+        }
+        return KPK_UNKNOWN;
+    }
+
+    // stalemate, or the pawn can be taken
+    BitBoard covered = king_moves[white_king] | pawn_attacks[WHITE][pawn];
+    if (!(king_moves[black_king] & ~covered) ||
+        (king_moves[black_king] & setBit(pawn) & ~king_moves[white_king])) {
+        return KPK_DRAW;
+    }
+    return KPK_UNKNOWN;
+}
+
+/*
+White to move wins if any move reaches a win and draws if every move reaches a draw, black is the
+other way round. Positions that aren't decided yet are left unknown for the next pass.
+*/
+static uint8_t classify(const KPKPosition &pos, const std::vector<KPKPosition> &db) {
+    Color side = pos.side_to_move;
+    Color other = getOtherSide(side);
+    Square king = pos.kings[side];
+    uint8_t good = side == WHITE ? KPK_WIN : KPK_DRAW;
+    uint8_t bad = side == WHITE ? KPK_DRAW : KPK_WIN;
+    uint8_t result = KPK_INVALID;
+
+    BitBoard moves = king_moves[king];
+    while (moves) {
+        Square to = popLSB(moves);
+        result |= side == WHITE ? db[kpkIndex(to, pos.pawn, pos.kings[BLACK], other)].result
+                                : db[kpkIndex(pos.kings[WHITE], pos.pawn, to, other)].result;
+    }
+
+    if (side == WHITE && pos.pawn / 8 < 6) {
+        Square push = static_cast<Square>(pos.pawn + 8);
+        result |= db[kpkIndex(pos.kings[WHITE], push, pos.kings[BLACK], BLACK)].result;
+        if (pos.pawn / 8 == 1 && push != pos.kings[WHITE] && push != pos.kings[BLACK]) {
+            Square double_push = static_cast<Square>(pos.pawn + 16);
+            result |= db[kpkIndex(pos.kings[WHITE], double_push, pos.kings[BLACK], BLACK)].result;
+        }
+    }
+
+    if (result & good) return good;
+    if (result & KPK_UNKNOWN) return KPK_UNKNOWN;
+    return bad;
+}
+
+void initKPK() {
+    std::vector<KPKPosition> db(KPK_POSITIONS);
+
+    for (int index = 0; index < KPK_POSITIONS; index++) {
+        KPKPosition &pos = db[index];
+        pos.kings[WHITE] = static_cast<Square>(index & 63);
+        pos.kings[BLACK] = static_cast<Square>((index >> 6) & 63);
+        pos.side_to_move = static_cast<Color>((index >> 12) & 1);
+        pos.pawn = static_cast<Square>(((index >> 13) & 3) + 8 * (((index >> 15) & 7) + 1));
+        pos.result = initialResult(pos);
+    }
+
+    // every pass settles at least one more position until nothing changes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto &pos : db) {
+            if (pos.result != KPK_UNKNOWN) continue;
+            pos.result = classify(pos, db);
+            changed |= pos.result != KPK_UNKNOWN;
+        }
+    }
+
+    for (int index = 0; index < KPK_POSITIONS; index++) {
+        if (db[index].result == KPK_WIN) kpk_bits[index / 64] |= 1ULL << (index % 64);
+    }
+}
+
+bool probeKPK(Square white_king, Square white_pawn, Square black_king, Color side_to_move) {
+    assert(white_pawn % 8 <= 3 && white_pawn / 8 >= 1 && white_pawn / 8 <= 6);
+    int index = kpkIndex(white_king, white_pawn, black_king, side_to_move);
+    return kpk_bits[index / 64] & (1ULL << (index % 64));
+}
+
+}  // namespace Spotlight
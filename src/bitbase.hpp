@@ -0,0 +1,21 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace Spotlight {
+
+/*
+Win/draw bitbase for king and pawn against king, one bit per position with white as the side
+with the pawn and the pawn on files a-d (anything else is mirrored onto that first). Indexed by
+both king squares, the side to move and the 24 squares a pawn can stand on.
+*/
+const int KPK_POSITIONS = 2 * 24 * 64 * 64;
+
+// built by retrograde iteration from the positions where the result is known outright, needs
+// the move tables so must come after initMoves
+void initKPK();
+
+// true if white wins with the pawn on files a-d, false for a draw
+bool probeKPK(Square white_king, Square white_pawn, Square black_king, Color side_to_move);
+
+}  // namespace Spotlight
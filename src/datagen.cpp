@@ -45,7 +45,7 @@ void playGames(int num_games, U64 node_count, int id, int& games_played, std::mu
     TT tt;
     std::atomic<bool> is_stopped(false);
 
-    Search search(&tt, &is_stopped, [&]() { return search.nodes_searched; });
+    Search search(&tt, &is_stopped);
     search.make_output = false;
 
     std::random_device r;
@@ -0,0 +1,107 @@
+#include "endgame.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "bitbase.hpp"
+#include "bitboards.hpp"
+#include "eval.hpp"
+#include "utils.hpp"
+
+namespace Spotlight {
+
+static inline int kingDistance(Square a, Square b) {
+    return std::max(std::abs(a % 8 - b % 8), std::abs(a / 8 - b / 8));
+}
+
+static inline int edgeDistance(Square sq) {
+    return std::min({sq % 8, 7 - sq % 8, sq / 8, 7 - sq / 8});
+}
+
+static inline bool darkSquare(Square sq) { return (sq % 8 + sq / 8) % 2 == 0; }
+
+// endgame material of one side, so that winning more material still raises the score
+template <Color side>
+static int sideMaterial(const BitBoard *bitboards) {
+    int material = 0;
+    for (int pt = PAWN; pt < KING; pt++) {
+        material += countBits(bitboards[getPieceID(static_cast<PieceType>(pt), side)]) *
+                    egScore(eval_params->piece_values[pt]);
+    }
+    return material;
+}
+
+int evalDraw(const BitBoard *, Color) { return 0; }
+
+template <Color strong>
+int evalKXK(const BitBoard *bitboards, Color side_to_move) {
+    constexpr Color weak = getOtherSide(strong);
+    Square strong_king = static_cast<Square>(__builtin_ctzll(bitboards[getPieceID(KING, strong)]));
+    Square weak_king = static_cast<Square>(__builtin_ctzll(bitboards[getPieceID(KING, weak)]));
+
+    int score = KNOWN_WIN + sideMaterial<strong>(bitboards) + 20 * (3 - edgeDistance(weak_king)) +
+                10 * (7 - kingDistance(strong_king, weak_king));
+
+    return side_to_move == strong ? score : -score;
+}
+
+template <Color strong>
+int evalKBNK(const BitBoard *bitboards, Color side_to_move) {
+    constexpr Color weak = getOtherSide(strong);
+    Square strong_king = static_cast<Square>(__builtin_ctzll(bitboards[getPieceID(KING, strong)]));
+    Square weak_king = static_cast<Square>(__builtin_ctzll(bitboards[getPieceID(KING, weak)]));
+    Square bishop = static_cast<Square>(__builtin_ctzll(bitboards[getPieceID(BISHOP, strong)]));
+
+    // only the two corners the bishop controls are mating corners
+    int corner_distance = darkSquare(bishop)
+                              ? std::min(kingDistance(weak_king, A1), kingDistance(weak_king, H8))
+                              : std::min(kingDistance(weak_king, H1), kingDistance(weak_king, A8));
+
+    int score = KNOWN_WIN + sideMaterial<strong>(bitboards) + 20 * (7 - corner_distance) +
+                10 * (7 - kingDistance(strong_king, weak_king));
+
+    return side_to_move == strong ? score : -score;
+}
+
+template <Color strong>
+int evalKPK(const BitBoard *bitboards, Color side_to_move) {
+    constexpr Color weak = getOtherSide(strong);
+    Square strong_king = static_cast<Square>(__builtin_ctzll(bitboards[getPieceID(KING, strong)]));
+    Square weak_king = static_cast<Square>(__builtin_ctzll(bitboards[getPieceID(KING, weak)]));
+    Square pawn = static_cast<Square>(__builtin_ctzll(bitboards[getPieceID(PAWN, strong)]));
+
+    // the bitbase has white as the strong side with the pawn on files a-d
+    if constexpr (strong == BLACK) {
+        strong_king = static_cast<Square>(strong_king ^ 56);
+        weak_king = static_cast<Square>(weak_king ^ 56);
+        pawn = static_cast<Square>(pawn ^ 56);
+    }
+    if (pawn % 8 > 3) {
+        strong_king = static_cast<Square>(strong_king ^ 7);
+        weak_king = static_cast<Square>(weak_king ^ 7);
+        pawn = static_cast<Square>(pawn ^ 7);
+    }
+
+    Color us = side_to_move == strong ? WHITE : BLACK;
+    if (!probeKPK(strong_king, pawn, weak_king, us)) return 0;
+
+    // pushing the pawn is progress
+    int score = KNOWN_WIN + egScore(eval_params->piece_values[PAWN]) + 20 * (pawn / 8);
+
+    return side_to_move == strong ? score : -score;
+}
+
+int scaleOppositeBishops(const BitBoard *bitboards) {
+    Square white_bishop = static_cast<Square>(__builtin_ctzll(bitboards[WHITE_BISHOP]));
+    Square black_bishop = static_cast<Square>(__builtin_ctzll(bitboards[BLACK_BISHOP]));
+    return darkSquare(white_bishop) != darkSquare(black_bishop) ? SCALE_NORMAL / 2 : SCALE_NORMAL;
+}
+
+template int evalKXK<WHITE>(const BitBoard *bitboards, Color side_to_move);
+template int evalKXK<BLACK>(const BitBoard *bitboards, Color side_to_move);
+template int evalKBNK<WHITE>(const BitBoard *bitboards, Color side_to_move);
+template int evalKBNK<BLACK>(const BitBoard *bitboards, Color side_to_move);
+template int evalKPK<WHITE>(const BitBoard *bitboards, Color side_to_move);
+template int evalKPK<BLACK>(const BitBoard *bitboards, Color side_to_move);
+
+}  // namespace Spotlight
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace Spotlight {
+
+// added to the score of endgames we know how to win, well clear of any normal eval
+const int KNOWN_WIN = 10000;
+
+int evalDraw(const BitBoard *bitboards, Color side_to_move);
+
+// lone king against a queen or rook (pawns allowed), or enough minors to mate
+template <Color strong>
+int evalKXK(const BitBoard *bitboards, Color side_to_move);
+
+// king, bishop and knight against a lone king, mating in the corner of the bishop's colour
+template <Color strong>
+int evalKBNK(const BitBoard *bitboards, Color side_to_move);
+
+// king and a single pawn against a lone king, exact win or draw from the KPK bitbase
+template <Color strong>
+int evalKPK(const BitBoard *bitboards, Color side_to_move);
+
+// only a bishop each plus pawns, drawish when the bishops are on opposite colours
+int scaleOppositeBishops(const BitBoard *bitboards);
+
+}  // namespace Spotlight
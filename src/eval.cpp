@@ -1,21 +1,187 @@
 #include "eval.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "bitboards.hpp"
 
 namespace Spotlight {
 
-int eval(Position &pos) {
-    int early_eval = 0;
-    int late_eval = 0;
-    int game_phase = 0;
+const EvalParams *eval_params = &default_eval_params;
+
+// the current EvalFile mapping, or a heap copy where mmap isn't available
+static void *eval_mapping = nullptr;
+static size_t eval_mapping_size = 0;
+
+static void releaseEvalFile() {
+    if (!eval_mapping) return;
+#if defined(__linux__)
+    munmap(eval_mapping, eval_mapping_size);
+#else
+    delete static_cast<EvalParams *>(eval_mapping);
+#endif
+    eval_mapping = nullptr;
+    eval_mapping_size = 0;
+}
+
+U64 evalParamsChecksum(const EvalParams &params) {
+    U64 hash = 0xcbf29ce484222325ULL;
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&params);
+    for (size_t i = 0; i < sizeof(EvalParams); i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static bool validHeader(const EvalFileHeader &header) {
+    return std::memcmp(header.magic, EVAL_FILE_MAGIC, sizeof(EVAL_FILE_MAGIC)) == 0 &&
+           header.version == EVAL_FILE_VERSION && header.params_size == sizeof(EvalParams);
+}
+
+/*
+Maps the file read-only and points eval_params straight at it, so there is nothing to parse
+beyond checking the header and checksum. Leaves the current params alone on failure.
+*/
+bool loadEvalFile(const std::string &path) {
+    constexpr size_t file_size = sizeof(EvalFileHeader) + sizeof(EvalParams);
+    EvalFileHeader header;
+    const EvalParams *params;
+
+#if defined(__linux__)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) != file_size) {
+        close(fd);
+        return false;
+    }
+
+    void *mem = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) return false;
+
+    std::memcpy(&header, mem, sizeof(header));
+    params = reinterpret_cast<const EvalParams *>(static_cast<char *>(mem) + sizeof(header));
+    if (!validHeader(header) || header.checksum != evalParamsChecksum(*params)) {
+        munmap(mem, file_size);
+        return false;
+    }
+#else
+    std::ifstream in_file(path, std::ios::binary);
+    if (!in_file.is_open()) return false;
+
+    EvalParams *mem = new EvalParams;
+    if (!in_file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        !in_file.read(reinterpret_cast<char *>(mem), sizeof(EvalParams)) ||
+        !validHeader(header) || header.checksum != evalParamsChecksum(*mem)) {
+        delete mem;
+        return false;
+    }
+    params = mem;
+#endif
+
+    releaseEvalFile();
+    eval_mapping = mem;
+    eval_mapping_size = file_size;
+    eval_params = params;
+    piece_square_scores = makePieceSquareScores(*eval_params);
+    return true;
+}
+
+bool writeEvalFile(const std::string &path, const EvalParams &params) {
+    std::ofstream out_file(path, std::ios::binary);
+    if (!out_file.is_open()) return false;
+
+    EvalFileHeader header{};
+    std::memcpy(header.magic, EVAL_FILE_MAGIC, sizeof(EVAL_FILE_MAGIC));
+    header.version = EVAL_FILE_VERSION;
+    header.params_size = sizeof(EvalParams);
+    header.checksum = evalParamsChecksum(params);
+
+    out_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out_file.write(reinterpret_cast<const char *>(&params), sizeof(params));
+    return static_cast<bool>(out_file);
+}
+
+void useDefaultEvalParams() {
+    eval_params = &default_eval_params;
+    piece_square_scores = makePieceSquareScores(*eval_params);
+    releaseEvalFile();
+}
+
+/*
+NNUE eval when the position keeps accumulators, otherwise a tapered piece square table eval
+using the scores kept up to date by Position. Build with -DEVAL_DEBUG (make debug) to check
+every call against a full recompute.
+*/
+int eval(Position &pos, PawnTable *pawn_table, MaterialTable *material_table) {
+    if (pos.use_nnue) {
+#ifdef EVAL_DEBUG
+        Accumulator fresh;
+        resetAccumulator(fresh);
+        for (int i = 0; i < 64; i++) {
+            Piece piece = pos.at(static_cast<Square>(i));
+            if (piece != NO_PIECE) addFeature(fresh, piece, static_cast<Square>(i));
+        }
+        assert(std::equal(&fresh.values[0][0], &fresh.values[0][0] + 2 * NNUE_HIDDEN,
+                          &pos.accumulators.back().values[0][0]));
+#endif
+        return nnueEvaluate(pos.accumulators.back(), pos.side_to_move);
+    }
+
+    MaterialEntry computed;
+    const MaterialEntry *material;
+    if (material_table) {
+        material = material_table->probe(pos);
+    } else {
+        computed = computeMaterial(pos.bitboards);
+        material = &computed;
+    }
+    if (material->endgame) return material->endgame(pos.bitboards, pos.side_to_move);
+
+    Score score = pos.psq_score + material->imbalance +
+                  (pawn_table ? pawn_table->probe(pos) : evalPawnStructure(pos));
+    int scale = material->scale ? material->scale(pos.bitboards) : SCALE_NORMAL;
+    int total_eval = taperedEval(score, material->phase, scale, pos.side_to_move);
+
+#ifdef EVAL_DEBUG
+    assert(pos.pawn_key == pos.generatePawnKey());
+    assert(pos.material_key == generateMaterialKey(pos.bitboards));
+    assert(total_eval == evalFromScratch(pos));
+#endif
+
+    return total_eval;
+}
+
+/*
+The same eval computed by looping over every piece. This is the one implementation of every
+term: with an EvalTrace it also records the coefficients the tuner needs.
+*/
+template <typename Trace>
+int evalFromScratch(Position &pos, Trace &trace) {
+    MaterialEntry material = computeMaterial(pos.bitboards, trace);
+    if constexpr (Trace::enabled) trace.phase = material.phase;
+    if (material.endgame) return material.endgame(pos.bitboards, pos.side_to_move);
+
+    Score score = material.imbalance;
     BitBoard occ = pos.bitboards[WHITE_OCCUPANCY];
 
     while (occ) {
         Square i = popLSB(occ);
         PieceType pt = getPieceType(pos.at(i));
-        game_phase += phase_values[pt];
-        early_eval += piece_values[0][pt] + piece_square_tables[pt][0][i ^ 56];
-        late_eval += piece_values[1][pt] + piece_square_tables[pt][1][i ^ 56];
+        score += eval_params->piece_values[pt] + eval_params->piece_square_tables[pt][i ^ 56];
+        trace.add(TERM_PSQT + pt * 64 + (i ^ 56), WHITE);
     }
 
     occ = pos.bitboards[BLACK_OCCUPANCY];
@@ -23,21 +189,17 @@ int eval(Position &pos) {
     while (occ) {
         Square i = popLSB(occ);
         PieceType pt = getPieceType(pos.at(i));
-        game_phase += phase_values[pt];
-        early_eval -= piece_values[0][pt] + piece_square_tables[pt][0][i];
-        late_eval -= piece_values[1][pt] + piece_square_tables[pt][1][i];
+        score -= eval_params->piece_values[pt] + eval_params->piece_square_tables[pt][i];
+        trace.add(TERM_PSQT + pt * 64 + i, BLACK);
     }
 
-    int total_eval =
-        (early_eval * game_phase + late_eval * (TOTAL_PHASE - game_phase)) / TOTAL_PHASE;
+    score += evalPawnStructure(pos, trace);
 
-    // assert(game_phase == TOTAL_PHASE || total_eval != early_eval);
-
-    if (pos.side_to_move == BLACK) {
-        total_eval *= -1;
-    }
-
-    return total_eval;
+    int scale = material.scale ? material.scale(pos.bitboards) : SCALE_NORMAL;
+    return taperedEval(score, material.phase, scale, pos.side_to_move);
 }
 
+template int evalFromScratch<NoTrace>(Position &pos, NoTrace &trace);
+template int evalFromScratch<EvalTrace>(Position &pos, EvalTrace &trace);
+
 }  // namespace Spotlight
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "evaltrace.hpp"
+#include "material.hpp"
+#include "pawns.hpp"
 #include "position.hpp"
 #include "types.hpp"
 #include "utils.hpp"
@@ -8,283 +15,182 @@ namespace Spotlight {
 
 // piece values
 
-constexpr int piece_values[2][6] = {{100, 250, 300, 400, 900, 0}, {100, 250, 300, 400, 900, 0}};
+constexpr Score piece_values[6] = {S(100, 100), S(250, 250), S(300, 300),
+                                   S(400, 400), S(900, 900), S(0, 0)};
 constexpr int phase_values[6] = {0, 3, 3, 5, 8, 0};
 const int TOTAL_PHASE = phase_values[PAWN] * 16 + phase_values[KNIGHT] * 4 +
                         phase_values[BISHOP] * 4 + phase_values[ROOK] * 4 + phase_values[QUEEN] * 2;
 
-// piece square tables
+// pawn structure, passed pawns indexed by rank from the pawn's own side
+constexpr Score passed_pawn[8] = {S(0, 0),   S(0, 10),   S(0, 15),   S(5, 25),
+                                  S(15, 45), S(30, 75),  S(50, 110), S(0, 0)};
+constexpr Score isolated_pawn = S(-10, -10);
+constexpr Score doubled_pawn = S(-10, -20);
+
+// material imbalance
+constexpr Score bishop_pair = S(30, 50);
+
+// piece square tables, [piece type][square] with a8 first, so white looks them up with sq ^ 56
 
 // clang-format off
-constexpr int piece_square_tables[6][2][64] = {
+constexpr Score piece_square_tables[6][64] = {
     {
-        {
-              0,   0,   0,   0,   0,   0,   0,   0,
-             93, 110,  66,  91,  74,  19,  19,  18,
-            -19,  19,  -6,  34,  27,  21,   0, -24,
-            -59, -22, -23,  -8,  -1, -18, -11, -50,
-            -62, -41, -32, -14, -14, -23, -24, -58,
-            -62, -34, -30, -41, -33, -38,   3, -49,
-            -79, -39, -47, -65, -58, -21,  -4, -58,
-              0,   0,   0,   0,   0,   0,   0,   0,
-        },
-        {
-              0,   0,   0,   0,   0,   0,   0,   0,
-             98, 103, 101,  86,  80,  99, 101,  85,
-             70,  71,  63,  47,  33,  41,  56,  45,
-             35,  26,   6,  -8,  -8,  -5,   7,  20,
-             22,  14,  -1, -14, -12, -11,   0,   2,
-             15,   6,  -8,   0,  -6,  -3, -10,  -2,
-             26,  12,  -1,  -9,   4,  -5,  -8,  -1,
-              0,   0,   0,   0,   0,   0,   0,   0,
-        },
+        S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0),
+        S(  93,  98), S( 110, 103), S(  66, 101), S(  91,  86), S(  74,  80), S(  19,  99), S(  19, 101), S(  18,  85),
+        S( -19,  70), S(  19,  71), S(  -6,  63), S(  34,  47), S(  27,  33), S(  21,  41), S(   0,  56), S( -24,  45),
+        S( -59,  35), S( -22,  26), S( -23,   6), S(  -8,  -8), S(  -1,  -8), S( -18,  -5), S( -11,   7), S( -50,  20),
+        S( -62,  22), S( -41,  14), S( -32,  -1), S( -14, -14), S( -14, -12), S( -23, -11), S( -24,   0), S( -58,   2),
+        S( -62,  15), S( -34,   6), S( -30,  -8), S( -41,   0), S( -33,  -6), S( -38,  -3), S(   3, -10), S( -49,  -2),
+        S( -79,  26), S( -39,  12), S( -47,  -1), S( -65,  -9), S( -58,   4), S( -21,  -5), S(  -4,  -8), S( -58,  -1),
+        S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0),
     },
     {
-        {
-            -73,   6, -18,  50,  85, -71,  16, -14,
-             19,  56,  89, 118,  82, 120,  26,  58,
-             80,  88, 111, 118, 121, 114, 108,  76,
-             68,  63, 100, 100,  94, 105,  76,  87,
-             40,  53,  73,  73,  85,  77,  66,  55,
-             28,  55,  54,  59,  66,  65,  72,  38,
-              8,  -1,  39,  47,  51,  60,  43,  30,
-              1,  23,  10,   9,  17,  23,  31, -18,
-        },
-        {
-            -47, -43, -11, -28, -37,   2, -36, -51,
-            -29, -27, -18, -24, -21, -33, -30, -55,
-            -36, -17,  -8, -10, -14, -13, -13, -29,
-            -29,  -6, -13,  -2,  19,  10,  -2, -40,
-            -23,  -8,  10,   3,   0,  -1, -19, -22,
-            -43, -22,  -3,  -2,  -3, -14, -29, -59,
-            -39, -22, -33, -21, -15, -36, -36, -38,
-            -61, -89, -26, -36, -36, -38, -71, -52,
-        },
+        S( -73, -47), S(   6, -43), S( -18, -11), S(  50, -28), S(  85, -37), S( -71,   2), S(  16, -36), S( -14, -51),
+        S(  19, -29), S(  56, -27), S(  89, -18), S( 118, -24), S(  82, -21), S( 120, -33), S(  26, -30), S(  58, -55),
+        S(  80, -36), S(  88, -17), S( 111,  -8), S( 118, -10), S( 121, -14), S( 114, -13), S( 108, -13), S(  76, -29),
+        S(  68, -29), S(  63,  -6), S( 100, -13), S( 100,  -2), S(  94,  19), S( 105,  10), S(  76,  -2), S(  87, -40),
+        S(  40, -23), S(  53,  -8), S(  73,  10), S(  73,   3), S(  85,   0), S(  77,  -1), S(  66, -19), S(  55, -22),
+        S(  28, -43), S(  55, -22), S(  54,  -3), S(  59,  -2), S(  66,  -3), S(  65, -14), S(  72, -29), S(  38, -59),
+        S(   8, -39), S(  -1, -22), S(  39, -33), S(  47, -21), S(  51, -15), S(  60, -36), S(  43, -36), S(  30, -38),
+        S(   1, -61), S(  23, -89), S(  10, -26), S(   9, -36), S(  17, -36), S(  23, -38), S(  31, -71), S( -18, -52),
     },
     {
-        {
-             37, -42,   0,  -8,   4, -67, -49,  57,
-              8,  45,  36,   9,  64,  46,  45,  32,
-             31,  60,  65, 102, 108, 105,  69,  58,
-             27,  49,  51,  87,  89,  88,  52,  48,
-             38,  46,  62,  72,  73,  49,  70,  41,
-             30,  52,  44,  46,  36,  57,  49,  27,
-             33,  39,  53,  33,  44,  44,  58,  15,
-            -11,   9,  20,  16,  20,  18,  13,   9,
-        },
-        {
-            -49, -45, -38, -25, -44, -22, -34, -73,
-            -41, -39, -48, -43, -55, -56, -43, -62,
-            -45, -44, -40, -52, -64, -37, -58, -42,
-            -51, -32, -30, -43, -47, -52, -38, -56,
-            -52, -51, -33, -39, -43, -35, -63, -62,
-            -72, -49, -42, -31, -30, -49, -55, -56,
-            -75, -72, -66, -53, -58, -63, -74, -96,
-            -87, -53, -99, -62, -69, -91, -87, -72,
-        },
+        S(  37, -49), S( -42, -45), S(   0, -38), S(  -8, -25), S(   4, -44), S( -67, -22), S( -49, -34), S(  57, -73),
+        S(   8, -41), S(  45, -39), S(  36, -48), S(   9, -43), S(  64, -55), S(  46, -56), S(  45, -43), S(  32, -62),
+        S(  31, -45), S(  60, -44), S(  65, -40), S( 102, -52), S( 108, -64), S( 105, -37), S(  69, -58), S(  58, -42),
+        S(  27, -51), S(  49, -32), S(  51, -30), S(  87, -43), S(  89, -47), S(  88, -52), S(  52, -38), S(  48, -56),
+        S(  38, -52), S(  46, -51), S(  62, -33), S(  72, -39), S(  73, -43), S(  49, -35), S(  70, -63), S(  41, -62),
+        S(  30, -72), S(  52, -49), S(  44, -42), S(  46, -31), S(  36, -30), S(  57, -49), S(  49, -55), S(  27, -56),
+        S(  33, -75), S(  39, -72), S(  53, -66), S(  33, -53), S(  44, -58), S(  44, -63), S(  58, -74), S(  15, -96),
+        S( -11, -87), S(   9, -53), S(  20, -99), S(  16, -62), S(  20, -69), S(  18, -91), S(  13, -87), S(   9, -72),
     },
     {
-        {
-             95, 108, 105, 114, 109, 113,  87,  94,
-             72,  93, 109, 110, 114, 114,  81,  89,
-             58,  88,  77, 101, 111, 104,  91,  75,
-             10,  21,  57,  70,  65,  71,  50,  22,
-            -14,  -5,  12,  20,  38,   8,  19,  -3,
-            -21,  -4,  -8, -17,  13,   3,  16,  -5,
-            -34,  -2,  10,   7,   7,  17,  -2, -56,
-             -4,   3,   6,  25,  35,  19, -32, -10,
-        },
-        {
-              8,   2,   7,   6,   2,  -1,  15,  15,
-             21,   9,   4,   8,   6,   4,  12,  18,
-             21,  11,  18,  15,   2,   4,   8,   7,
-             25,  24,  15,  13,  13,   5,  12,  21,
-             24,  26,  23,  21,   8,  21,  13,  12,
-             13,  15,  18,  20,   4,  11,   9, -10,
-             10,  -3,   6,  -1,  -1,   7,  16,   6,
-              9,  10,  23,  13,   0,  10,  37, -16,
-        },
+        S(  95,   8), S( 108,   2), S( 105,   7), S( 114,   6), S( 109,   2), S( 113,  -1), S(  87,  15), S(  94,  15),
+        S(  72,  21), S(  93,   9), S( 109,   4), S( 110,   8), S( 114,   6), S( 114,   4), S(  81,  12), S(  89,  18),
+        S(  58,  21), S(  88,  11), S(  77,  18), S( 101,  15), S( 111,   2), S( 104,   4), S(  91,   8), S(  75,   7),
+        S(  10,  25), S(  21,  24), S(  57,  15), S(  70,  13), S(  65,  13), S(  71,   5), S(  50,  12), S(  22,  21),
+        S( -14,  24), S(  -5,  26), S(  12,  23), S(  20,  21), S(  38,   8), S(   8,  21), S(  19,  13), S(  -3,  12),
+        S( -21,  13), S(  -4,  15), S(  -8,  18), S( -17,  20), S(  13,   4), S(   3,  11), S(  16,   9), S(  -5, -10),
+        S( -34,  10), S(  -2,  -3), S(  10,   6), S(   7,  -1), S(   7,  -1), S(  17,   7), S(  -2,  16), S( -56,   6),
+        S(  -4,   9), S(   3,  10), S(   6,  23), S(  25,  13), S(  35,   0), S(  19,  10), S( -32,  37), S( -10, -16),
     },
     {
-        {
-            -55, -21,  31,  88,  41,  66,  -8, -15,
-            -57, -46,  -7, -25,  23,   2,  13,  -3,
-            -32, -32, -10,  27,  25,  25,   1,  14,
-            -46, -30, -15,  -9,  -9,  -2, -27, -11,
-            -24, -42, -30, -28,  -8, -24, -22, -35,
-            -47, -23, -27, -24, -32, -23, -20, -27,
-            -70, -30, -11, -17, -20, -10, -29, -54,
-            -31, -53, -35, -20, -21, -56, -44, -43,
-        },
-        {
-            -64, -69, -78, -98, -57, -68, -88, -66,
-            -34, -49, -50, -22, -52, -46, -62, -54,
-            -82, -70, -59, -51, -46, -34, -27, -38,
-            -63, -74, -47, -40, -27,  -7, -25, -43,
-            -92, -80, -47, -26, -70, -45, -33, -14,
-            -78, -97, -62, -78, -76, -52, -60, -73,
-            -68,-121,-121,-122,-105,-124,-118,-113,
-           -110, -92,-111,-117,-120,-108,-109, -55,
-        },
+        S( -55, -64), S( -21, -69), S(  31, -78), S(  88, -98), S(  41, -57), S(  66, -68), S(  -8, -88), S( -15, -66),
+        S( -57, -34), S( -46, -49), S(  -7, -50), S( -25, -22), S(  23, -52), S(   2, -46), S(  13, -62), S(  -3, -54),
+        S( -32, -82), S( -32, -70), S( -10, -59), S(  27, -51), S(  25, -46), S(  25, -34), S(   1, -27), S(  14, -38),
+        S( -46, -63), S( -30, -74), S( -15, -47), S(  -9, -40), S(  -9, -27), S(  -2,  -7), S( -27, -25), S( -11, -43),
+        S( -24, -92), S( -42, -80), S( -30, -47), S( -28, -26), S(  -8, -70), S( -24, -45), S( -22, -33), S( -35, -14),
+        S( -47, -78), S( -23, -97), S( -27, -62), S( -24, -78), S( -32, -76), S( -23, -52), S( -20, -60), S( -27, -73),
+        S( -70, -68), S( -30,-121), S( -11,-121), S( -17,-122), S( -20,-105), S( -10,-124), S( -29,-118), S( -54,-113),
+        S( -31,-110), S( -53, -92), S( -35,-111), S( -20,-117), S( -21,-120), S( -56,-108), S( -44,-109), S( -43, -55),
     },
     {
-        {
-            -85, 151, 118, -11, -15,  52,  39, 159,
-            -27,   2,  -6, -39,  86,  30,   8, 106,
-            -69, -26, -10, -55, -25, -35,  24, -47,
-            -24,  -2,  -6, -56, -32, -11,  -1, -55,
-            -15,   5, -54, -17, -45, -58, -42, -86,
-             -3, -38, -60, -78, -73, -60, -24, -50,
-             32,  16, -26, -50, -50,  -4,  11,  28,
-             43,   9,  16, -39,  22, -21,  58,  49,
-        },
-        {
-           -108, -70, -32, -12,  -8, -28,   0, -55,
-            -14,   9,  57,  69,  46,  49,  28,   7,
-             31,   8,  37,  68,  79,  73,  32,  34,
-             20,  38,  49,  69,  67,  64,  56,  53,
-             20,  31,  53,  55,  64,  66,  53,  50,
-             18,  35,  50,  61,  65,  54,  36,  35,
-              4,  19,  32,  43,  50,  35,  23,   6,
-            -14,   0,  11,   5, -21,   7, -13, -31,
-        },
+        S( -85,-108), S( 151, -70), S( 118, -32), S( -11, -12), S( -15,  -8), S(  52, -28), S(  39,   0), S( 159, -55),
+        S( -27, -14), S(   2,   9), S(  -6,  57), S( -39,  69), S(  86,  46), S(  30,  49), S(   8,  28), S( 106,   7),
+        S( -69,  31), S( -26,   8), S( -10,  37), S( -55,  68), S( -25,  79), S( -35,  73), S(  24,  32), S( -47,  34),
+        S( -24,  20), S(  -2,  38), S(  -6,  49), S( -56,  69), S( -32,  67), S( -11,  64), S(  -1,  56), S( -55,  53),
+        S( -15,  20), S(   5,  31), S( -54,  53), S( -17,  55), S( -45,  64), S( -58,  66), S( -42,  53), S( -86,  50),
+        S(  -3,  18), S( -38,  35), S( -60,  50), S( -78,  61), S( -73,  65), S( -60,  54), S( -24,  36), S( -50,  35),
+        S(  32,   4), S(  16,  19), S( -26,  32), S( -50,  43), S( -50,  50), S(  -4,  35), S(  11,  23), S(  28,   6),
+        S(  43, -14), S(   9,   0), S(  16,  11), S( -39,   5), S(  22, -21), S( -21,   7), S(  58, -13), S(  49, -31),
     },
-    
-// {
-//     {
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//     },
-//     {
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//           0,   0,   0,   0,   0,   0,   0,   0,
-//     },
-// },
-// {
-//   {
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//   },
-//   {
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//   },
-// },
-// {
-//   {
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//   },
-//   {
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//   },
-// },
-// {
-//   {
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//   },
-//   {
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//   },
-// },
-// {
-//   {
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//   },
-//   {
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//   },
-// },
-// {
-//   {
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//   },
-//   {
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//         0,   0,   0,   0,   0,   0,   0,   0,
-//   },
-// },
 };
 // clang-format on
 
-int eval(Position &pos);
+// everything the eval reads from a parameter file, as laid out on disk (int32, little-endian)
+struct EvalParams {
+    Score piece_values[6];
+    Score piece_square_tables[6][64];
+    Score passed_pawn[8];
+    Score isolated_pawn;
+    Score doubled_pawn;
+    Score bishop_pair;
+};
+
+// the tables above, used unless an EvalFile is loaded
+constexpr EvalParams default_eval_params = [] {
+    EvalParams params{};
+    for (int pt = PAWN; pt <= KING; pt++) {
+        params.piece_values[pt] = piece_values[pt];
+        for (int sq = 0; sq < 64; sq++) {
+            params.piece_square_tables[pt][sq] = piece_square_tables[pt][sq];
+        }
+    }
+    for (int rank = 0; rank < 8; rank++) {
+        params.passed_pawn[rank] = passed_pawn[rank];
+    }
+    params.isolated_pawn = isolated_pawn;
+    params.doubled_pawn = doubled_pawn;
+    params.bishop_pair = bishop_pair;
+    return params;
+}();
+
+/*
+Eval parameter file: a header followed directly by an EvalParams. The checksum is FNV-1a over
+the params so a truncated or edited file is rejected rather than silently used.
+*/
+const char EVAL_FILE_MAGIC[8] = {'S', 'P', 'O', 'T', 'L', 'E', 'V', '\0'};
+const uint32_t EVAL_FILE_VERSION = 4;
+
+struct EvalFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t params_size;
+    U64 checksum;
+};
+
+static_assert(sizeof(EvalFileHeader) % alignof(EvalParams) == 0);
+
+// points at default_eval_params or into the mapped EvalFile
+extern const EvalParams *eval_params;
+
+using PieceSquareScores = std::array<std::array<Score, 64>, 12>;
+
+/*
+Material plus piece square value of every piece on every square, indexed [piece][square].
+Positive for white pieces and negative for black ones. Position uses these to keep its
+psq_score up to date as pieces move.
+*/
+constexpr PieceSquareScores makePieceSquareScores(const EvalParams &params) {
+    PieceSquareScores scores{};
+    for (int pt = PAWN; pt <= KING; pt++) {
+        for (int sq = 0; sq < 64; sq++) {
+            scores[pt][sq] = params.piece_values[pt] + params.piece_square_tables[pt][sq ^ 56];
+            scores[pt + 6][sq] = -(params.piece_values[pt] + params.piece_square_tables[pt][sq]);
+        }
+    }
+    return scores;
+}
+
+// rebuilt whenever eval_params changes. Positions need refreshScores() afterwards
+inline constinit PieceSquareScores piece_square_scores = makePieceSquareScores(default_eval_params);
+
+U64 evalParamsChecksum(const EvalParams &params);
+
+bool loadEvalFile(const std::string &path);
+
+bool writeEvalFile(const std::string &path, const EvalParams &params);
+
+void useDefaultEvalParams();
+
+// blend of the mg and eg parts by game phase, with the eg part scaled, side to move relative
+inline int taperedEval(Score score, int phase, int scale, Color side_to_move) {
+    int total_eval = (mgScore(score) * phase +
+                      egScore(score) * scale / SCALE_NORMAL * (TOTAL_PHASE - phase)) /
+                     TOTAL_PHASE;
+    return side_to_move == BLACK ? -total_eval : total_eval;
+}
+
+// the tables cache the pawn structure and material terms, without them they are computed
+// every call
+int eval(Position &pos, PawnTable *pawn_table = nullptr, MaterialTable *material_table = nullptr);
+
+template <typename Trace>
+int evalFromScratch(Position &pos, Trace &trace);
+
+inline int evalFromScratch(Position &pos) {
+    NoTrace trace;
+    return evalFromScratch(pos, trace);
+}
 
 }  // namespace Spotlight
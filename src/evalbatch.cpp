@@ -0,0 +1,228 @@
+#include "evalbatch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bitboards.hpp"
+#include "eval.hpp"
+#include "pawns.hpp"
+#include "utils.hpp"
+
+namespace Spotlight {
+
+const uint16_t EMPTY_FEATURE = NO_PIECE * 64;
+
+// lines read per chunk of the fen file, split evenly between the threads
+const size_t FEN_CHUNK_SIZE = 1 << 16;
+// score of a line addFen rejected, written to the output as "invalid" so it can't pass for a 0
+const int INVALID_FEN_SCORE = std::numeric_limits<int>::min();
+
+EvalBatch::EvalBatch() : boards{}, count(0) {
+    for (auto &slot : features) {
+        std::fill(std::begin(slot), std::end(slot), EMPTY_FEATURE);
+    }
+    std::fill(std::begin(side_to_move), std::end(side_to_move), WHITE);
+}
+
+bool EvalBatch::add(Position &pos) {
+    if (full() || countBits(pos.bitboards[OCCUPANCY]) > MAX_BOARD_PIECES) return false;
+
+    int slot = 0;
+    BitBoard occ = pos.bitboards[OCCUPANCY];
+    while (occ) {
+        Square sq = popLSB(occ);
+        features[slot++][count] = pos.at(sq) * 64 + sq;
+    }
+    std::copy(pos.bitboards, pos.bitboards + 12, boards[count]);
+    side_to_move[count] = pos.side_to_move;
+    count++;
+    return true;
+}
+
+// reads only the piece placement and side to move, much cheaper than Position::readFen
+bool EvalBatch::addFen(std::string_view fen) {
+    if (full()) return false;
+
+    int slot = 0;
+    int square_index = 56;
+    BitBoard *board = boards[count];
+    std::fill(board, board + 12, 0ULL);
+    size_t i = 0;
+
+    for (; i < fen.size() && fen[i] != ' '; i++) {
+        char c = fen[i];
+        if (isdigit(c)) {
+            square_index += c - '0';
+        } else if (c == '/') {
+            square_index -= 16;
+        } else {
+            Piece piece = letterToPiece(c);
+            if (piece == NO_PIECE || slot == MAX_BOARD_PIECES || square_index < 0 ||
+                square_index > 63) {
+                for (int k = 0; k < slot; k++) features[k][count] = EMPTY_FEATURE;
+                return false;
+            }
+            features[slot++][count] = piece * 64 + square_index;
+            board[piece] |= setBit(square_index);
+            square_index++;
+        }
+    }
+
+    // the material and endgame code needs exactly one king each
+    if (countBits(board[WHITE_KING]) != 1 || countBits(board[BLACK_KING]) != 1) {
+        for (int k = 0; k < slot; k++) features[k][count] = EMPTY_FEATURE;
+        return false;
+    }
+
+    side_to_move[count] = i + 1 < fen.size() && fen[i + 1] == 'b' ? BLACK : WHITE;
+    count++;
+    return true;
+}
+
+void EvalBatch::evaluate(int *out) {
+    // piece_square_scores flattened, with a zero row for empty slots
+    std::array<Score, 13 * 64> table{};
+    for (int piece = WHITE_PAWN; piece <= BLACK_KING; piece++) {
+        for (int sq = 0; sq < 64; sq++) {
+            table[piece * 64 + sq] = piece_square_scores[piece][sq];
+        }
+    }
+
+    alignas(64) Score scores[EVAL_BATCH_SIZE] = {};
+    alignas(64) int phase[EVAL_BATCH_SIZE] = {};
+    alignas(64) int scale[EVAL_BATCH_SIZE] = {};
+    EndgameFn endgames[EVAL_BATCH_SIZE];
+
+    for (int slot = 0; slot < MAX_BOARD_PIECES; slot++) {
+        const uint16_t *slot_features = features[slot];
+        for (int i = 0; i < EVAL_BATCH_SIZE; i++) {
+            scores[i] += table[slot_features[i]];
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        const MaterialEntry *material =
+            material_table.probe(generateMaterialKey(boards[i]), boards[i]);
+        scores[i] += material->imbalance +
+                     evalPawnStructure(boards[i][WHITE_PAWN], boards[i][BLACK_PAWN]);
+        phase[i] = material->phase;
+        scale[i] = material->scale ? material->scale(boards[i]) : SCALE_NORMAL;
+        endgames[i] = material->endgame;
+    }
+
+    // blend over the whole batch so the loop has a fixed trip count and vectorises
+    alignas(64) int totals[EVAL_BATCH_SIZE];
+    for (int i = 0; i < EVAL_BATCH_SIZE; i++) {
+        totals[i] = taperedEval(scores[i], phase[i], scale[i], side_to_move[i]);
+    }
+    std::copy(totals, totals + count, out);
+
+    // the few boards with a specialised endgame evaluator replace the blended score
+    for (int i = 0; i < count; i++) {
+        if (endgames[i]) out[i] = endgames[i](boards[i], side_to_move[i]);
+    }
+
+    for (auto &slot : features) {
+        std::fill(std::begin(slot), std::begin(slot) + count, EMPTY_FEATURE);
+    }
+    count = 0;
+}
+
+void evalBatch(std::span<Position> positions, std::span<int> scores) {
+    auto batch = std::make_unique<EvalBatch>();
+    size_t start = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        if (batch->full()) {
+            batch->evaluate(&scores[start]);
+            start = i;
+        }
+        // a board that doesn't fit falls back to the normal eval
+        if (!batch->add(positions[i])) {
+            batch->evaluate(&scores[start]);
+            scores[i] = evalFromScratch(positions[i]);
+            start = i + 1;
+        }
+    }
+    batch->evaluate(&scores[start]);
+}
+
+// scores a range of fen lines into scores, one batch at a time
+static void evalFenLines(const std::vector<std::string> &lines, size_t begin, size_t end,
+                         std::vector<int> &scores) {
+    auto batch = std::make_unique<EvalBatch>();
+    size_t start = begin;
+    for (size_t i = begin; i < end; i++) {
+        if (batch->full()) {
+            batch->evaluate(&scores[start]);
+            start = i;
+        }
+        if (!batch->addFen(lines[i])) {
+            batch->evaluate(&scores[start]);
+            scores[i] = INVALID_FEN_SCORE;
+            start = i + 1;
+        }
+    }
+    batch->evaluate(&scores[start]);
+}
+
+void evalFenFile(const std::string &in_path, const std::string &out_path, int num_threads) {
+    std::ifstream in_file(in_path);
+    if (!in_file.is_open()) {
+        std::cout << "could not open " << in_path << "\n";
+        return;
+    }
+    std::ofstream out_file;
+    if (!out_path.empty()) out_file.open(out_path);
+
+    num_threads = std::max(num_threads, 1);
+    std::vector<std::string> lines;
+    std::vector<int> scores;
+    U64 total = 0;
+    U64 invalid = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    while (in_file) {
+        lines.clear();
+        std::string line;
+        while (lines.size() < FEN_CHUNK_SIZE && std::getline(in_file, line)) {
+            if (!line.empty()) lines.push_back(std::move(line));
+        }
+        if (lines.empty()) break;
+        scores.assign(lines.size(), 0);
+
+        std::vector<std::thread> threads;
+        size_t per_thread = (lines.size() + num_threads - 1) / num_threads;
+        for (size_t begin = 0; begin < lines.size(); begin += per_thread) {
+            size_t end = std::min(begin + per_thread, lines.size());
+            threads.emplace_back(evalFenLines, std::cref(lines), begin, end, std::ref(scores));
+        }
+        for (auto &thread : threads) thread.join();
+
+        for (int score : scores) {
+            if (score == INVALID_FEN_SCORE) {
+                invalid++;
+                if (out_file.is_open()) out_file << "invalid\n";
+            } else if (out_file.is_open()) {
+                out_file << score << "\n";
+            }
+        }
+        total += lines.size();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << total << " positions evaluated in " << elapsed.count() << "s, "
+              << static_cast<U64>(total / std::max(elapsed.count(), 1e-9)) << " positions/sec with "
+              << num_threads << " threads\n";
+    if (invalid) std::cout << invalid << " invalid lines written as \"invalid\"\n";
+}
+
+}  // namespace Spotlight
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "material.hpp"
+#include "position.hpp"
+#include "types.hpp"
+
+namespace Spotlight {
+
+const int EVAL_BATCH_SIZE = 256;
+const int MAX_BOARD_PIECES = 32;
+
+/*
+Evaluates many positions at once with the PSQT + pawn structure eval (never NNUE). Boards are
+stored as structure-of-arrays piece lists: slot k of every board sits next to each other, as a
+piece * 64 + square index, so the main loop is a straight run of table lookups over the batch
+that the compiler can vectorise with gathers. Empty slots point at a row of zeros. The piece
+bitboards are kept alongside for the pawn structure and material terms, which are per board.
+*/
+class EvalBatch {
+   public:
+    EvalBatch();
+
+    // both return false, adding nothing, when the batch is full or the board doesn't fit
+    bool add(Position &pos);
+    bool addFen(std::string_view fen);
+
+    // writes one score per added board, side to move relative, in the order they were added,
+    // then empties the batch
+    void evaluate(int *scores);
+
+    inline int size() const { return count; }
+    inline bool full() const { return count == EVAL_BATCH_SIZE; }
+
+   private:
+    alignas(64) uint16_t features[MAX_BOARD_PIECES][EVAL_BATCH_SIZE];
+    BitBoard boards[EVAL_BATCH_SIZE][12];
+    Color side_to_move[EVAL_BATCH_SIZE];
+    int count;
+    MaterialTable material_table;
+};
+
+void evalBatch(std::span<Position> positions, std::span<int> scores);
+
+// scores every FEN in a file (one per line) using num_threads threads, optionally writing the
+// scores to out_path in the same order, and reports positions per second. Lines that aren't a
+// valid board are written as "invalid"
+void evalFenFile(const std::string &in_path, const std::string &out_path, int num_threads);
+
+}  // namespace Spotlight
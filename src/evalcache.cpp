@@ -0,0 +1,29 @@
+#include "evalcache.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace Spotlight {
+
+EvalCache::EvalCache() : probes(0ULL), hits(0ULL), entries(), mask(0ULL) {
+    resize(EVAL_CACHE_DEFAULT_MB);
+}
+
+// rounds down to a power of two entries so the index is a mask of the key
+void EvalCache::resize(size_t size_in_mb) {
+    size_t num_entries = size_in_mb * 1024 * 1024 / sizeof(U64);
+    if (num_entries) num_entries = std::bit_floor(num_entries);
+    entries.assign(num_entries, 0ULL);
+    entries.shrink_to_fit();
+    mask = num_entries ? num_entries - 1 : 0ULL;
+    probes = 0ULL;
+    hits = 0ULL;
+}
+
+void EvalCache::clear() {
+    std::fill(entries.begin(), entries.end(), 0ULL);
+    probes = 0ULL;
+    hits = 0ULL;
+}
+
+}  // namespace Spotlight
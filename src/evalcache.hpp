@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "types.hpp"
+
+namespace Spotlight {
+
+// off by default, with the current eval the cache costs more than it saves
+const size_t EVAL_CACHE_DEFAULT_MB = 0;
+
+/*
+Small direct-mapped cache of static evals per search thread, so a position reached again in a
+sibling subtree isn't evaluated twice. Each entry is one word: the top 48 bits of the zobrist
+key and the 16-bit eval below them. Zero entries disable the cache.
+*/
+class EvalCache {
+   public:
+    EvalCache();
+
+    void resize(size_t size_in_mb);
+    void clear();
+
+    inline bool probe(U64 z_key, int &score) {
+        if (entries.empty()) return false;
+        probes++;
+        U64 entry = entries[z_key & mask];
+        if ((entry ^ z_key) >> 16) return false;
+        hits++;
+        score = static_cast<int16_t>(entry & 0xffff);
+        return true;
+    }
+
+    inline void save(U64 z_key, int score) {
+        if (entries.empty()) return;
+        entries[z_key & mask] = (z_key & ~0xffffULL) | static_cast<uint16_t>(score);
+    }
+
+    U64 probes;
+    U64 hits;
+
+   private:
+    std::vector<U64> entries;
+    U64 mask;
+};
+
+}  // namespace Spotlight
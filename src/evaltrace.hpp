@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+
+#include "types.hpp"
+
+namespace Spotlight {
+
+// every tunable eval term, in the same order as the matching fields of EvalParams
+enum EvalTerm : int {
+    TERM_PSQT = 0,
+    TERM_PASSED_PAWN = TERM_PSQT + 6 * 64,
+    TERM_ISOLATED_PAWN = TERM_PASSED_PAWN + 8,
+    TERM_DOUBLED_PAWN,
+    TERM_BISHOP_PAIR,
+    NUM_EVAL_TERMS
+};
+
+static_assert(NUM_EVAL_TERMS == 6 * 64 + 8 + 3);
+
+/*
+Trace policies for the eval. NoTrace compiles to nothing, EvalTrace counts how often each term
+is applied for each side, which is exactly the coefficient the tuner needs.
+*/
+struct NoTrace {
+    static constexpr bool enabled = false;
+    inline void add(int, Color, int = 1) {}
+};
+
+struct EvalTrace {
+    static constexpr bool enabled = true;
+    inline void add(int term, Color side, int count = 1) { coeffs[term][side] += count; }
+
+    std::array<std::array<int, 2>, NUM_EVAL_TERMS> coeffs{};
+    int phase = 0;
+};
+
+}  // namespace Spotlight
@@ -1,5 +1,9 @@
+#include <thread>
+
+#include "bitbase.hpp"
 #include "datagen.hpp"
 #include "eval.hpp"
+#include "evalbatch.hpp"
 #include "move.hpp"
 #include "position.hpp"
 #include "test.hpp"
@@ -14,12 +18,29 @@ int main(int argc, char* argv[]) {
     initMoves();
     initMagics();
     initZobrist();
+    initKPK();
 
     if (argc == 1) {
         UCI uci;
         uci.loop();
     } else if (static_cast<std::string>(argv[1]) == "searchtest") {
         testSearch();
+    } else if (static_cast<std::string>(argv[1]) == "bench") {
+        int hash_mb = argc > 2 ? std::stoi(argv[2]) : 16;
+        int depth = argc > 3 ? std::stoi(argv[3]) : 12;
+        U64 nodes = argc > 4 ? std::stoull(argv[4]) : 0;
+        size_t eval_cache_mb = argc > 5 ? std::stoull(argv[5]) : EVAL_CACHE_DEFAULT_MB;
+        bench(hash_mb, depth, nodes, eval_cache_mb);
+    } else if (static_cast<std::string>(argv[1]) == "smpbench") {
+        int hash_mb = argc > 2 ? std::stoi(argv[2]) : 64;
+        int depth = argc > 3 ? std::stoi(argv[3]) : 12;
+        int max_threads = argc > 4 ? std::stoi(argv[4]) : 32;
+        benchSMP(hash_mb, depth, max_threads);
+    } else if (static_cast<std::string>(argv[1]) == "ttbench") {
+        benchTT(argc > 2 ? std::stoi(argv[2]) : 16);
+    } else if (static_cast<std::string>(argv[1]) == "evalfens" && argc > 2) {
+        int threads = argc > 3 ? std::stoi(argv[3]) : std::thread::hardware_concurrency();
+        evalFenFile(argv[2], argc > 4 ? argv[4] : "", threads);
     } else if (static_cast<std::string>(argv[1]) == "fulltest") {
         runTests();
     } else if (static_cast<std::string>(argv[1]) == "tune") {
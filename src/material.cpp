@@ -0,0 +1,111 @@
+#include "material.hpp"
+
+#include "bitboards.hpp"
+#include "endgame.hpp"
+#include "eval.hpp"
+#include "zobrist.hpp"
+
+namespace Spotlight {
+
+// every piece type gets one key per count, so the key only depends on how many of each there are
+U64 generateMaterialKey(const BitBoard *bitboards) {
+    U64 key = 0ULL;
+    for (int piece = WHITE_PAWN; piece <= BLACK_KING; piece++) {
+        int count = countBits(bitboards[piece]);
+        for (int i = 0; i < count; i++) {
+            key ^= piece_keys[piece][i];
+        }
+    }
+    return key;
+}
+
+template <typename Trace>
+MaterialEntry computeMaterial(const BitBoard *bitboards, Trace &trace) {
+    MaterialEntry entry{};
+    entry.scale = nullptr;
+    entry.endgame = nullptr;
+
+    int counts[12];
+    for (int piece = WHITE_PAWN; piece <= BLACK_KING; piece++) {
+        counts[piece] = countBits(bitboards[piece]);
+        entry.phase += counts[piece] * phase_values[getPieceType(static_cast<Piece>(piece))];
+    }
+
+    for (Color side : {WHITE, BLACK}) {
+        if (counts[getPieceID(BISHOP, side)] >= 2) {
+            entry.imbalance += side == WHITE ? eval_params->bishop_pair : -eval_params->bishop_pair;
+        }
+    }
+
+    int pawns[2], knights[2], bishops[2], majors[2];
+    for (Color side : {WHITE, BLACK}) {
+        pawns[side] = counts[getPieceID(PAWN, side)];
+        knights[side] = counts[getPieceID(KNIGHT, side)];
+        bishops[side] = counts[getPieceID(BISHOP, side)];
+        majors[side] = counts[getPieceID(ROOK, side)] + counts[getPieceID(QUEEN, side)];
+    }
+
+    // no pawns or majors and at most one minor each side can't be won
+    if (!pawns[WHITE] && !pawns[BLACK] && !majors[WHITE] && !majors[BLACK] &&
+        knights[WHITE] + bishops[WHITE] <= 1 && knights[BLACK] + bishops[BLACK] <= 1) {
+        entry.endgame = evalDraw;
+        return entry;
+    }
+    for (Color side : {WHITE, BLACK}) {
+        if (!pawns[side] && !majors[side] && !bishops[side] && knights[side] == 2 &&
+            !pawns[side ^ 1] && !majors[side ^ 1] && !bishops[side ^ 1] && !knights[side ^ 1]) {
+            entry.endgame = evalDraw;
+            return entry;
+        }
+    }
+
+    for (Color strong : {WHITE, BLACK}) {
+        Color weak = getOtherSide(strong);
+        bool weak_bare = !pawns[weak] && !knights[weak] && !bishops[weak] && !majors[weak];
+        if (!weak_bare) continue;
+
+        if (pawns[strong] == 1 && !majors[strong] && !knights[strong] && !bishops[strong]) {
+            entry.endgame = strong == WHITE ? evalKPK<WHITE> : evalKPK<BLACK>;
+            return entry;
+        }
+        if (!pawns[strong] && !majors[strong] && knights[strong] == 1 && bishops[strong] == 1) {
+            entry.endgame = strong == WHITE ? evalKBNK<WHITE> : evalKBNK<BLACK>;
+            return entry;
+        }
+        if (majors[strong] || bishops[strong] >= 2 ||
+            (bishops[strong] && knights[strong])) {
+            entry.endgame = strong == WHITE ? evalKXK<WHITE> : evalKXK<BLACK>;
+            return entry;
+        }
+    }
+
+    if (bishops[WHITE] == 1 && bishops[BLACK] == 1 && !knights[WHITE] && !knights[BLACK] &&
+        !majors[WHITE] && !majors[BLACK]) {
+        entry.scale = scaleOppositeBishops;
+    }
+
+    // only traced once we know no endgame function replaces the eval, since the tuner would
+    // otherwise get a gradient for a term that never reaches the score
+    for (Color side : {WHITE, BLACK}) {
+        if (bishops[side] >= 2) trace.add(TERM_BISHOP_PAIR, side);
+    }
+
+    return entry;
+}
+
+template MaterialEntry computeMaterial<NoTrace>(const BitBoard *bitboards, NoTrace &trace);
+template MaterialEntry computeMaterial<EvalTrace>(const BitBoard *bitboards, EvalTrace &trace);
+
+MaterialTable::MaterialTable() : probes(0ULL), hits(0ULL), entries(MATERIAL_TABLE_ENTRIES) {
+    clear();
+}
+
+void MaterialTable::clear() {
+    for (auto &entry : entries) {
+        entry = MaterialEntry{};
+    }
+    probes = 0ULL;
+    hits = 0ULL;
+}
+
+}  // namespace Spotlight
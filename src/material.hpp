@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+
+#include "evaltrace.hpp"
+#include "position.hpp"
+#include "types.hpp"
+
+namespace Spotlight {
+
+const size_t MATERIAL_TABLE_ENTRIES = 1 << 13;
+
+// eg scale factors, SCALE_NORMAL leaves the endgame score as is
+const int SCALE_NORMAL = 64;
+
+// specialised evaluators replace the whole eval, side to move relative
+using EndgameFn = int (*)(const BitBoard *bitboards, Color side_to_move);
+// scaling functions return a factor out of SCALE_NORMAL for the endgame part of the score
+using ScaleFn = int (*)(const BitBoard *bitboards);
+
+// everything the eval derives from the piece counts alone
+struct MaterialEntry {
+    U64 key;
+    Score imbalance;
+    int phase;
+    EndgameFn endgame;
+    ScaleFn scale;
+};
+
+U64 generateMaterialKey(const BitBoard *bitboards);
+
+template <typename Trace>
+MaterialEntry computeMaterial(const BitBoard *bitboards, Trace &trace);
+
+inline MaterialEntry computeMaterial(const BitBoard *bitboards) {
+    NoTrace trace;
+    return computeMaterial(bitboards, trace);
+}
+
+/*
+Direct-mapped cache of MaterialEntry keyed by Position::material_key, one per search thread.
+There are few distinct material configurations in a search so this almost always hits. Empty
+entries have key 0, which no position has since both kings are always counted.
+*/
+class MaterialTable {
+   public:
+    MaterialTable();
+
+    inline const MaterialEntry *probe(U64 material_key, const BitBoard *bitboards) {
+        probes++;
+        MaterialEntry &entry = entries[material_key & (MATERIAL_TABLE_ENTRIES - 1)];
+        if (entry.key == material_key) {
+            hits++;
+            return &entry;
+        }
+        entry = computeMaterial(bitboards);
+        entry.key = material_key;
+        return &entry;
+    }
+
+    inline const MaterialEntry *probe(Position &pos) {
+        return probe(pos.material_key, pos.bitboards);
+    }
+
+    void clear();
+
+    U64 probes;
+    U64 hits;
+
+   private:
+    std::vector<MaterialEntry> entries;
+};
+
+}  // namespace Spotlight
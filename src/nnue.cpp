@@ -0,0 +1,98 @@
+#include "nnue.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+namespace Spotlight {
+
+Network network;
+bool network_loaded = false;
+bool nnue_enabled = false;
+
+bool loadNetwork(const std::string &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+
+    constexpr size_t expected = sizeof(network.feature_weights) + sizeof(network.feature_bias) +
+                                sizeof(network.output_weights) + sizeof(network.output_bias);
+    size_t file_size = file.tellg();
+    if (file_size < expected || file_size > expected + 64) return false;
+
+    // read into a scratch copy so a truncated read leaves the current net untouched
+    auto loaded = std::make_unique<Network>();
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(loaded->feature_weights), sizeof(loaded->feature_weights));
+    file.read(reinterpret_cast<char *>(loaded->feature_bias), sizeof(loaded->feature_bias));
+    file.read(reinterpret_cast<char *>(loaded->output_weights), sizeof(loaded->output_weights));
+    file.read(reinterpret_cast<char *>(&loaded->output_bias), sizeof(loaded->output_bias));
+    if (!file) return false;
+
+    network = *loaded;
+    network_loaded = true;
+    return true;
+}
+
+void resetAccumulator(Accumulator &acc) {
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        acc.values[WHITE][i] = network.feature_bias[i];
+        acc.values[BLACK][i] = network.feature_bias[i];
+    }
+}
+
+/*
+sum of screlu(x) * w over one half of the hidden layer, where screlu(x) = clamp(x, 0, QA)^2.
+v * w is taken first so it fits in 16 bits (|w| stays below 128 with QB = 64), then multiplied
+by v again with madd into 32-bit lanes.
+*/
+static int screluDot(const int16_t *values, const int16_t *weights) {
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i qa = _mm256_set1_epi16(NNUE_QA);
+    __m256i sum = zero;
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+        __m256i w = _mm256_load_si256(reinterpret_cast<const __m256i *>(weights + i));
+        v = _mm256_min_epi16(_mm256_max_epi16(v, zero), qa);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, _mm256_mullo_epi16(v, w)));
+    }
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum128);
+#elif defined(__SSE4_1__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i qa = _mm_set1_epi16(NNUE_QA);
+    __m128i sum = zero;
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(values + i));
+        __m128i w = _mm_load_si128(reinterpret_cast<const __m128i *>(weights + i));
+        v = _mm_min_epi16(_mm_max_epi16(v, zero), qa);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(v, _mm_mullo_epi16(v, w)));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int sum = 0;
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        int v = std::clamp(static_cast<int>(values[i]), 0, NNUE_QA);
+        sum += static_cast<int16_t>(v * weights[i]) * v;
+    }
+    return sum;
+#endif
+}
+
+int nnueEvaluate(const Accumulator &acc, Color side_to_move) {
+    int sum = screluDot(acc.values[side_to_move], network.output_weights) +
+              screluDot(acc.values[side_to_move ^ 1], network.output_weights + NNUE_HIDDEN);
+
+    // screlu leaves an extra factor of QA which is divided out before adding the bias
+    return (sum / NNUE_QA + network.output_bias) * NNUE_SCALE / (NNUE_QA * NNUE_QB);
+}
+
+}  // namespace Spotlight
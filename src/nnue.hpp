@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "types.hpp"
+
+namespace Spotlight {
+
+/*
+A simple 768 -> NNUE_HIDDEN -> 1 perspective network. Each side has its own accumulator over the
+same feature transformer, both go through a squared clipped ReLU and the side to move's half is
+multiplied by the first half of the output weights.
+
+Feature index for a piece from a perspective: (piece colour relative to the perspective) * 384 +
+piece type * 64 + square, with the board flipped vertically for black. Squares are numbered
+a1 = 0 to h8 = 63.
+*/
+constexpr int NNUE_INPUTS = 768;
+constexpr int NNUE_HIDDEN = 256;
+
+// quantisation of the feature transformer and the output layer, and the eval scale in cp
+constexpr int NNUE_QA = 255;
+constexpr int NNUE_QB = 64;
+constexpr int NNUE_SCALE = 400;
+
+/*
+Network file layout, all little-endian int16: feature weights [768][NNUE_HIDDEN], feature bias
+[NNUE_HIDDEN], output weights [2 * NNUE_HIDDEN], output bias. Trailing padding up to 64 bytes
+is ignored so nets written by bullet load as is.
+*/
+struct alignas(64) Network {
+    int16_t feature_weights[NNUE_INPUTS * NNUE_HIDDEN];
+    int16_t feature_bias[NNUE_HIDDEN];
+    int16_t output_weights[2 * NNUE_HIDDEN];
+    int16_t output_bias;
+};
+
+struct alignas(64) Accumulator {
+    int16_t values[2][NNUE_HIDDEN];
+};
+
+extern Network network;
+extern bool network_loaded;
+
+// set by the UseNNUE option. Positions pick it up in readFen / refreshAccumulators
+extern bool nnue_enabled;
+
+bool loadNetwork(const std::string &path);
+
+inline int featureIndex(Color perspective, Piece piece, Square sq) {
+    int color = piece / 6;
+    int piece_type = piece % 6;
+    if (perspective == WHITE) {
+        return color * 384 + piece_type * 64 + sq;
+    }
+    return (color ^ 1) * 384 + piece_type * 64 + (sq ^ 56);
+}
+
+void resetAccumulator(Accumulator &acc);
+
+inline void addFeature(Accumulator &acc, Piece piece, Square sq) {
+    const int16_t *white = &network.feature_weights[featureIndex(WHITE, piece, sq) * NNUE_HIDDEN];
+    const int16_t *black = &network.feature_weights[featureIndex(BLACK, piece, sq) * NNUE_HIDDEN];
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        acc.values[WHITE][i] += white[i];
+        acc.values[BLACK][i] += black[i];
+    }
+}
+
+inline void removeFeature(Accumulator &acc, Piece piece, Square sq) {
+    const int16_t *white = &network.feature_weights[featureIndex(WHITE, piece, sq) * NNUE_HIDDEN];
+    const int16_t *black = &network.feature_weights[featureIndex(BLACK, piece, sq) * NNUE_HIDDEN];
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        acc.values[WHITE][i] -= white[i];
+        acc.values[BLACK][i] -= black[i];
+    }
+}
+
+// fused remove + add for a piece moving between two squares
+inline void moveFeature(Accumulator &acc, Piece piece, Square start, Square end) {
+    const int16_t *white_add =
+        &network.feature_weights[featureIndex(WHITE, piece, end) * NNUE_HIDDEN];
+    const int16_t *white_sub =
+        &network.feature_weights[featureIndex(WHITE, piece, start) * NNUE_HIDDEN];
+    const int16_t *black_add =
+        &network.feature_weights[featureIndex(BLACK, piece, end) * NNUE_HIDDEN];
+    const int16_t *black_sub =
+        &network.feature_weights[featureIndex(BLACK, piece, start) * NNUE_HIDDEN];
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        acc.values[WHITE][i] += white_add[i] - white_sub[i];
+        acc.values[BLACK][i] += black_add[i] - black_sub[i];
+    }
+}
+
+// eval in centipawns from the side to move's point of view
+int nnueEvaluate(const Accumulator &acc, Color side_to_move);
+
+}  // namespace Spotlight
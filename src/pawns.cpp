@@ -0,0 +1,74 @@
+#include "pawns.hpp"
+
+#include "bitboards.hpp"
+#include "eval.hpp"
+
+namespace Spotlight {
+
+template <Color side, typename Trace>
+static Score evalPawns(BitBoard ours, BitBoard theirs, Trace &trace) {
+    Score score = 0;
+
+    for (int file = 0; file < 8; file++) {
+        int count = countBits(ours & (A_FILE << file));
+        if (count > 1) {
+            score += eval_params->doubled_pawn * (count - 1);
+            trace.add(TERM_DOUBLED_PAWN, side, count - 1);
+        }
+    }
+
+    BitBoard pawns = ours;
+    while (pawns) {
+        Square sq = popLSB(pawns);
+        int file = sq % 8;
+        int rank = sq / 8;
+        BitBoard file_mask = A_FILE << file;
+        BitBoard adjacent_files = ((file_mask << 1) & NOT_A_FILE) | ((file_mask >> 1) & NOT_H_FILE);
+
+        if (!(ours & adjacent_files)) {
+            score += eval_params->isolated_pawn;
+            trace.add(TERM_ISOLATED_PAWN, side);
+        }
+
+        // squares in front of the pawn on its own and the adjacent files. only the front pawn of
+        // a doubled pair counts as passed
+        BitBoard in_front = side == WHITE ? ~0ULL << (8 * (rank + 1)) : (1ULL << (8 * rank)) - 1;
+        if (!(theirs & (file_mask | adjacent_files) & in_front) && !(ours & file_mask & in_front)) {
+            int relative_rank = side == WHITE ? rank : 7 - rank;
+            score += eval_params->passed_pawn[relative_rank];
+            trace.add(TERM_PASSED_PAWN + relative_rank, side);
+        }
+    }
+
+    return score;
+}
+
+template <typename Trace>
+Score evalPawnStructure(Position &pos, Trace &trace) {
+    BitBoard white_pawns = pos.bitboards[WHITE_PAWN];
+    BitBoard black_pawns = pos.bitboards[BLACK_PAWN];
+    return evalPawns<WHITE>(white_pawns, black_pawns, trace) -
+           evalPawns<BLACK>(black_pawns, white_pawns, trace);
+}
+
+Score evalPawnStructure(BitBoard white_pawns, BitBoard black_pawns) {
+    NoTrace trace;
+    return evalPawns<WHITE>(white_pawns, black_pawns, trace) -
+           evalPawns<BLACK>(black_pawns, white_pawns, trace);
+}
+
+template Score evalPawnStructure<NoTrace>(Position &pos, NoTrace &trace);
+template Score evalPawnStructure<EvalTrace>(Position &pos, EvalTrace &trace);
+
+PawnTable::PawnTable() : probes(0ULL), hits(0ULL), entries(PAWN_TABLE_ENTRIES) { clear(); }
+
+void PawnTable::clear() {
+    for (auto &entry : entries) {
+        entry.key = 0ULL;
+        entry.score = 0;
+    }
+    probes = 0ULL;
+    hits = 0ULL;
+}
+
+}  // namespace Spotlight
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+#include "evaltrace.hpp"
+#include "position.hpp"
+#include "types.hpp"
+
+namespace Spotlight {
+
+const size_t PAWN_TABLE_ENTRIES = 1 << 14;
+
+// passed, isolated and doubled pawn terms from white's point of view
+template <typename Trace>
+Score evalPawnStructure(Position &pos, Trace &trace);
+
+Score evalPawnStructure(BitBoard white_pawns, BitBoard black_pawns);
+
+inline Score evalPawnStructure(Position &pos) {
+    NoTrace trace;
+    return evalPawnStructure(pos, trace);
+}
+
+struct PawnEntry {
+    U64 key;
+    Score score;
+};
+
+/*
+Direct-mapped cache of evalPawnStructure keyed by Position::pawn_key. Each search thread owns
+one, so there is no locking. Pawns rarely move, so nearly every probe is a hit. An empty entry
+has key 0, which is also the key of a position without pawns whose score is 0 anyway.
+*/
+class PawnTable {
+   public:
+    PawnTable();
+
+    inline Score probe(Position &pos) {
+        probes++;
+        PawnEntry &entry = entries[pos.pawn_key & (PAWN_TABLE_ENTRIES - 1)];
+        if (entry.key == pos.pawn_key) {
+            hits++;
+            return entry.score;
+        }
+        entry.key = pos.pawn_key;
+        entry.score = evalPawnStructure(pos);
+        return entry.score;
+    }
+
+    void clear();
+
+    U64 probes;
+    U64 hits;
+
+   private:
+    std::vector<PawnEntry> entries;
+};
+
+}  // namespace Spotlight
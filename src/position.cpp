@@ -4,17 +4,23 @@
 #include <iostream>
 #include <sstream>
 
+#include "eval.hpp"
 #include "move.hpp"
 #include "utils.hpp"
 #include "zobrist.hpp"
 
 namespace Spotlight {
 
-template <bool update_zobrist>
+template <bool update_state>
 void Position::movePiece(Square start, Square end, Piece piece) {
-    if constexpr (update_zobrist) {
+    if constexpr (update_state) {
         z_key ^= piece_keys[piece][start];
         z_key ^= piece_keys[piece][end];
+        psq_score += piece_square_scores[piece][end] - piece_square_scores[piece][start];
+        if (getPieceType(piece) == PAWN) {
+            pawn_key ^= piece_keys[piece][start] ^ piece_keys[piece][end];
+        }
+        if (use_nnue) moveFeature(accumulators.back(), piece, start, end);
     }
     bitboards[piece] ^= setBit(start);
     bitboards[piece] ^= setBit(end);
@@ -28,10 +34,16 @@ void Position::movePiece(Square start, Square end, Piece piece) {
     board[end] = piece;
 }
 
-template <bool update_zobrist>
+template <bool update_state>
 void Position::removePiece(Square square, Piece piece) {
-    if constexpr (update_zobrist) z_key ^= piece_keys[piece][square];
+    if constexpr (update_state) {
+        z_key ^= piece_keys[piece][square];
+        psq_score -= piece_square_scores[piece][square];
+        if (getPieceType(piece) == PAWN) pawn_key ^= piece_keys[piece][square];
+        if (use_nnue) removeFeature(accumulators.back(), piece, square);
+    }
     bitboards[piece] ^= setBit(square);
+    if constexpr (update_state) material_key ^= piece_keys[piece][countBits(bitboards[piece])];
     bitboards[WHITE_OCCUPANCY] &= ~setBit(square);
     bitboards[BLACK_OCCUPANCY] &= ~setBit(square);
     bitboards[OCCUPANCY] &= ~setBit(square);
@@ -39,9 +51,15 @@ void Position::removePiece(Square square, Piece piece) {
     board[square] = Piece::NO_PIECE;
 }
 
-template <bool update_zobrist>
+template <bool update_state>
 void Position::placePiece(Square square, Piece piece) {
-    if constexpr (update_zobrist) z_key ^= piece_keys[piece][square];
+    if constexpr (update_state) {
+        z_key ^= piece_keys[piece][square];
+        psq_score += piece_square_scores[piece][square];
+        if (getPieceType(piece) == PAWN) pawn_key ^= piece_keys[piece][square];
+        material_key ^= piece_keys[piece][countBits(bitboards[piece])];
+        if (use_nnue) addFeature(accumulators.back(), piece, square);
+    }
     bitboards[piece] ^= setBit(square);
     bitboards[WHITE_OCCUPANCY + piece / 6] ^= setBit(square);
     bitboards[OCCUPANCY] ^= setBit(square);
@@ -143,6 +161,10 @@ void Position::readFen(std::string fen) {
     game_half_moves = half_moves;
 
     z_key = generateZobrist();
+    pawn_key = generatePawnKey();
+    material_key = generateMaterialKey(bitboards);
+    refreshScores();
+    refreshAccumulators();
 }
 
 std::string Position::toFen() {
@@ -243,6 +265,17 @@ void Position::printFromBitboard() {
     std::cout << "castle rights " << castle_rights << std::endl;
 };
 
+U64 Position::generatePawnKey() {
+    U64 key = 0ULL;
+    for (Piece piece : {WHITE_PAWN, BLACK_PAWN}) {
+        BitBoard pawns = bitboards[piece];
+        while (pawns) {
+            key ^= piece_keys[piece][popLSB(pawns)];
+        }
+    }
+    return key;
+}
+
 U64 Position::generateZobrist() {
     U64 zobrist = 0ULL;
 
@@ -258,7 +291,33 @@ U64 Position::generateZobrist() {
     return zobrist;
 }
 
-Position::Position() : in_check(false) {
+// recompute the incrementally updated eval terms from scratch
+void Position::refreshScores() {
+    psq_score = 0;
+
+    for (int i = 0; i < 64; i++) {
+        Piece piece = at(static_cast<Square>(i));
+        if (piece == NO_PIECE) continue;
+        psq_score += piece_square_scores[piece][i];
+    }
+}
+
+// rebuild the accumulator stack for the current position, picking up the UseNNUE setting
+void Position::refreshAccumulators() {
+    use_nnue = nnue_enabled;
+    accumulators.clear();
+    if (!use_nnue) return;
+
+    accumulators.reserve(256);
+    accumulators.emplace_back();
+    resetAccumulator(accumulators.back());
+    for (int i = 0; i < 64; i++) {
+        Piece piece = at(static_cast<Square>(i));
+        if (piece != NO_PIECE) addFeature(accumulators.back(), piece, static_cast<Square>(i));
+    }
+}
+
+Position::Position() : in_check(false), use_nnue(false) {
     // clearHistory();
     for (auto &i : board) {
         i = NO_PIECE;
@@ -284,8 +343,12 @@ void Position::makeMove(move16 move) {
     undo.fifty_move = fifty_move;
     undo.castle_rights = castle_rights;
     undo.z_key = z_key;
+    undo.pawn_key = pawn_key;
+    undo.psq_score = psq_score;
+    undo.material_key = material_key;
     undo.captured_piece = NO_PIECE;
     undo.in_check = in_check;
+    if (use_nnue) accumulators.push_back(accumulators.back());
     Piece captured_piece = NO_PIECE;
     if (en_passant) z_key ^= en_passant_keys[en_passant];
     en_passant = A1;
@@ -504,6 +567,10 @@ void Position::unmakeMove() {
     }
 
     z_key = undo.z_key;
+    pawn_key = undo.pawn_key;
+    psq_score = undo.psq_score;
+    material_key = undo.material_key;
+    if (use_nnue) accumulators.pop_back();
     history.pop_back();
 }
 
@@ -583,6 +650,8 @@ void Position::makeNullMove() {
     undo.en_passant = en_passant;
     undo.fifty_move = fifty_move;
     undo.z_key = z_key;
+    undo.movegen_data = movegen_data;
+    movegen_data = MoveGenData();
 
     if (en_passant) z_key ^= en_passant_keys[en_passant];
 
@@ -602,6 +671,7 @@ void Position::unmakeNullMove() {
     en_passant = undo.en_passant;
     fifty_move = undo.fifty_move;
     z_key = undo.z_key;
+    movegen_data = undo.movegen_data;
     half_moves--;
 
     history.pop_back();
@@ -619,11 +689,10 @@ bool Position::isTripleRepetition() {
     return repetitions >= 2;
 }
 
+// true when the side to move has any piece besides pawns and the king
 bool Position::zugzwangUnlikely() {
-    for (int p = getPieceID(KNIGHT, side_to_move); p < getPieceID(KING, side_to_move); p++) {
-        if (bitboards[p]) return true;
-    }
-    return false;
+    return bitboards[getOccupancy(side_to_move)] &
+           ~(bitboards[getPieceID(PAWN, side_to_move)] | bitboards[getPieceID(KING, side_to_move)]);
 }
 
 }  // namespace Spotlight
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 
+#include "nnue.hpp"
 #include "types.hpp"
 
 namespace Spotlight {
@@ -26,6 +27,9 @@ struct Undo {
     Square en_passant;
     int fifty_move;
     U64 z_key;
+    U64 pawn_key;
+    U64 material_key;
+    Score psq_score;
     Piece captured_piece;
     bool in_check;
     MoveGenData movegen_data;
@@ -42,24 +46,39 @@ class Position {
     int half_moves;
     int game_half_moves;
     U64 z_key;
+    // zobrist key of the pawns alone, for the pawn hash table
+    U64 pawn_key;
     bool in_check;
 
+    // piece counts only, for the material hash table
+    U64 material_key;
+
+    // material and piece square total from white's point of view, updated incrementally
+    Score psq_score;
+
     MoveGenData movegen_data;
 
     std::vector<Undo> history;
 
+    // NNUE accumulators, one per move made, only kept when use_nnue is set
+    bool use_nnue;
+    std::vector<Accumulator> accumulators;
+
     void readFen(std::string fen);
     std::string toFen();
     void print();
     void printFromBitboard();
     U64 generateZobrist();
+    U64 generatePawnKey();
+    void refreshScores();
+    void refreshAccumulators();
     bool isTripleRepetition();
 
-    template <bool update_zobrist>
+    template <bool update_state>
     void movePiece(Square start, Square end, Piece piece);
-    template <bool update_zobrist>
+    template <bool update_state>
     void removePiece(Square square, Piece piece);
-    template <bool update_zobrist>
+    template <bool update_state>
     void placePiece(Square square, Piece piece);
 
     void makeMove(move16 move);
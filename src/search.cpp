@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <sstream>
 
+#include "endgame.hpp"
 #include "movepicker.hpp"
 
 namespace Spotlight {
@@ -31,19 +32,27 @@ void PVTable::clearPV() {
 // sets the length of a particular pv index to zero (used before searching each ply)
 void PVTable::zeroLength(int ply) { pv_length[ply] = 0; }
 
-Search::Search(TT *_tt, std::atomic<bool> *_is_stopped, std::function<U64()> _getNodes)
-    : tt_hits(0),
-      nodes_searched(0),
-      q_nodes(0),
-      make_output(true),
+void SearchCounters::clear() {
+    nodes.store(0ULL, std::memory_order_relaxed);
+    q_nodes.store(0ULL, std::memory_order_relaxed);
+    tt_hits.store(0ULL, std::memory_order_relaxed);
+    sel_depth.store(0, std::memory_order_relaxed);
+}
+
+Search::Search(TT *_tt, std::atomic<bool> *_is_stopped,
+               const std::vector<const SearchCounters *> *_thread_counters)
+    : make_output(true),
+      abdada(false),
       thread_id(0),
       is_stopped(_is_stopped),
-      getNodes(_getNodes),
+      thread_counters(_thread_counters),
+      sync(nullptr),
       node_search(false),
       allow_nmp(true),
       times_up(false),
       enable_qsearch_tt(true),
       start_time(std::chrono::steady_clock::now()),
+      node_pool(nullptr),
       tt(_tt) {
     clearHistory();
     for (int i = 0; i < MAX_PLY; i++) {
@@ -64,6 +73,53 @@ Search::Search(TT *_tt, std::atomic<bool> *_is_stopped, std::function<U64()> _ge
 
 void Search::clearTT() { tt->clear(); }
 
+SearchSync::SearchSync(TT *_tt, std::vector<std::vector<TTWrite> *> _logs)
+    : tt(_tt),
+      logs(std::move(_logs)),
+      main_done(false),
+      stop(false),
+      barrier(static_cast<std::ptrdiff_t>(logs.size()), MergeLogs{this}) {}
+
+// runs on one thread once every thread has arrived, so nothing else touches the TT
+void SearchSync::MergeLogs::operator()() noexcept {
+    for (std::vector<TTWrite> *log : sync->logs) {
+        for (const TTWrite &w : *log) {
+            sync->tt->save(w.z_key, w.depth, w.ply, w.move, w.score, w.node_type, w.s_eval,
+                           w.is_pv);
+        }
+        log->clear();
+    }
+    sync->stop = sync->main_done.load();
+}
+
+bool SearchSync::endIteration() {
+    barrier.arrive_and_wait();
+    return stop;
+}
+
+void SearchSync::leave(int thread_id) {
+    if (thread_id == 0) main_done.store(true);
+    barrier.arrive_and_drop();
+}
+
+void Search::setDeterministic(bool enabled) {
+    if (enabled && !local_tt) {
+        local_tt = std::make_unique<TT>(DETERMINISTIC_TT_SIZE);
+    } else if (!enabled) {
+        local_tt.reset();
+        tt_log = std::vector<TTWrite>();
+    }
+}
+
+U64 Search::totalNodes() const {
+    if (!thread_counters) return counters.nodes.load(std::memory_order_relaxed);
+    U64 nodes = 0ULL;
+    for (const SearchCounters *thread : *thread_counters) {
+        nodes += thread->nodes.load(std::memory_order_relaxed);
+    }
+    return nodes;
+}
+
 void Search::clearKillers() {
     for (int i = 0; i < MAX_PLY; i++) {
         killer_1[i] = 0;
@@ -101,7 +157,7 @@ bool Search::timesUp() {
     if (times_up) {
         return true;
     } else if (node_search) {
-        if (nodes_searched >= max_nodes) {
+        if (counters.nodes.load(std::memory_order_relaxed) >= max_nodes && !reserveNodes()) {
             times_up = true;
             return true;
         }
@@ -125,6 +181,22 @@ bool Search::timesUp() {
     return false;
 }
 
+/*
+Takes another batch of nodes from the shared budget, so the pool is only touched once every
+NODE_BATCH_SIZE nodes. The last batch is whatever is left, so all threads together never search
+more than the budget. The first thread to find the pool empty stops the others.
+*/
+bool Search::reserveNodes() {
+    if (!node_pool || is_stopped->load(std::memory_order_relaxed)) return false;
+    int64_t remaining = node_pool->fetch_sub(NODE_BATCH_SIZE, std::memory_order_relaxed);
+    if (remaining <= 0) {
+        is_stopped->store(true);
+        return false;
+    }
+    max_nodes += std::min(remaining, NODE_BATCH_SIZE);
+    return true;
+}
+
 bool Search::softTimesUp() {
     if (node_search) {
         return false;
@@ -143,9 +215,10 @@ bool Search::softTimesUp() {
 void Search::outputInfo(int depth, move16 best_move, int score) {
     std::stringstream ss;
     std::chrono::duration<double> time_elapsed = std::chrono::steady_clock::now() - start_time;
-    U64 nodes = getNodes();
+    U64 nodes = totalNodes();
     U64 nps = nodes / time_elapsed.count();
-    ss << "info depth " << depth;
+    ss << "info depth " << depth << " seldepth "
+       << counters.sel_depth.load(std::memory_order_relaxed);
     if (score > MATE_THRESHOLD || score < -MATE_THRESHOLD) {
         ss << " score mate " << (pv.length() + 1) / 2;
     } else {
@@ -159,6 +232,15 @@ void Search::outputInfo(int depth, move16 best_move, int score) {
     std::cout << ss.str() << std::endl;
 }
 
+// static eval through the per-thread eval cache
+int Search::evaluate(Position &pos) {
+    int score;
+    if (eval_cache.probe(pos.z_key, score)) return score;
+    score = eval(pos, &pawn_table, &material_table);
+    eval_cache.save(pos.z_key, score);
+    return score;
+}
+
 // Timed search
 SearchResult Search::timeSearch(Position &pos, int max_depth, U64 time_in_ms) {
     node_search = false;
@@ -167,19 +249,24 @@ SearchResult Search::timeSearch(Position &pos, int max_depth, U64 time_in_ms) {
 }
 
 // search a fixed number of nodes
-SearchResult Search::nodeSearch(Position &pos, int max_depth, U64 num_nodes) {
+SearchResult Search::nodeSearch(Position &pos, int max_depth, U64 num_nodes,
+                                std::atomic<int64_t> *_node_pool) {
     node_search = true;
     times_up = false;
-    max_nodes = num_nodes;
-    return iterSearch(pos, max_depth);
-};
+    node_pool = _node_pool;
+    max_nodes = node_pool ? 0ULL : num_nodes;
+    SearchResult result = iterSearch(pos, max_depth);
+
+    // the main thread finishing early (max depth) ends the search for the helpers too
+    if (node_pool && thread_id == 0) is_stopped->store(true);
+    node_pool = nullptr;
+    return result;
+}
 
 // Iterative deepening framework
 SearchResult Search::iterSearch(Position &pos, int max_depth) {
-    nodes_searched = 0ULL;
-    q_nodes = 0ULL;
+    counters.clear();
     enable_qsearch_tt = true;
-    tt_hits = 0;
 
     pv.clearPV();
     clearKillers();
@@ -188,11 +275,31 @@ SearchResult Search::iterSearch(Position &pos, int max_depth) {
 
     move16 best_move = NULL_MOVE;
     int best_score = 0;
+    int completed_depth = 0;
 
     int beta = POSITIVE_INFINITY;
     int alpha = NEGATIVE_INFINITY;
 
-    for (int depth = 1; depth <= max_depth; depth++) {
+    for (int iteration = 1; iteration <= max_depth; iteration++) {
+        int depth = iteration;
+        if (sync) {
+            /*
+            Deterministic searches keep every thread on every barrier, so rather than skip
+            depths the helpers search one or two plies ahead of the main thread on the fixed
+            skipDepth schedule. A helper that is already at that depth waits out the iteration.
+            */
+            if (thread_id != 0) {
+                depth = std::min(iteration + 1 + skipDepth(thread_id, iteration), max_depth);
+                if (depth <= completed_depth) {
+                    if (depth == max_depth || sync->endIteration()) break;
+                    continue;
+                }
+            }
+        } else if (!abdada && depth < max_depth && skipDepth(thread_id, depth)) {
+            // ABDADA splits the work within an iteration instead
+            continue;
+        }
+
         /*
         Aspiration Windows
 
@@ -241,24 +348,71 @@ SearchResult Search::iterSearch(Position &pos, int max_depth) {
 
         best_move = pv.getPVMove(0);
         best_score = score;
+        completed_depth = depth;
 
         if (make_output && thread_id == 0) outputInfo(depth, best_move, best_score);
 
         // If our soft time limit has expired we don't start another search iteration
         if (softTimesUp()) break;
+
+        if (sync && iteration < max_depth && sync->endIteration()) break;
+    }
+
+    if (sync) {
+        sync->leave(thread_id);
+        sync = nullptr;
     }
 
     SearchResult result;
 
     result.move = best_move;
     result.score = best_score;
+    result.depth = completed_depth;
 
-    // assert(best_move);
+    return result;
+}
 
-    if (thread_id == 0 && make_output)
-        std::cout << "bestmove " << moveToString(best_move) << std::endl;
+/*
+Every thread votes for its move, weighted by how deep it got and how its score compares to the
+worst of them. The result with the most votes for its move wins, the deepest one for that move
+if several threads agree. A mate found by any thread is taken as is. Threads that never finished
+an iteration don't vote.
+*/
+SearchResult voteBestResult(const std::vector<SearchResult> &results) {
+    int min_score = POSITIVE_INFINITY;
+    for (const auto &result : results) {
+        if (result.move) min_score = std::min(min_score, result.score);
+    }
 
-    return result;
+    std::vector<std::pair<move16, int>> votes;
+    for (const auto &result : results) {
+        if (!result.move) continue;
+        auto it = std::find_if(votes.begin(), votes.end(),
+                               [&](const auto &vote) { return vote.first == result.move; });
+        if (it == votes.end()) it = votes.insert(votes.end(), {result.move, 0});
+        it->second += (result.score - min_score + 14) * result.depth;
+    }
+
+    auto voteFor = [&](move16 move) {
+        for (const auto &vote : votes) {
+            if (vote.first == move) return vote.second;
+        }
+        return 0;
+    };
+
+    SearchResult best = results[0];
+    for (const auto &result : results) {
+        if (!result.move) continue;
+        if (!best.move) {
+            best = result;
+        } else if (best.score > MATE_THRESHOLD || result.score > MATE_THRESHOLD) {
+            if (result.score > best.score) best = result;
+        } else if (voteFor(result.move) > voteFor(best.move) ||
+                   (result.move == best.move && result.depth > best.depth)) {
+            best = result;
+        }
+    }
+    return best;
 }
 
 /*
@@ -271,7 +425,7 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
     // check ply limit
     // we use MAX_PLY - 1 because some arrays are accessed with
     // index ply + 1
-    if (ply >= MAX_PLY - 1) return eval(pos);
+    if (ply >= MAX_PLY - 1) return eval(pos, &pawn_table, &material_table);
 
     // clear the pv at this ply
     pv.zeroLength(ply);
@@ -281,6 +435,12 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
         return 0;
     }
 
+    // king and pawn against king is an exact win or draw from the bitbase, nothing to search
+    if (!is_root && countBits(pos.bitboards[OCCUPANCY]) == 3) {
+        if (pos.bitboards[WHITE_PAWN]) return evalKPK<WHITE>(pos.bitboards, pos.side_to_move);
+        if (pos.bitboards[BLACK_PAWN]) return evalKPK<BLACK>(pos.bitboards, pos.side_to_move);
+    }
+
     bool in_check = inCheck(pos);
 
     // If we are at depth 0 then drop into the quiescence search
@@ -299,7 +459,7 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
     if (!is_root && alpha >= beta) return beta;
 
     // Increase node count only after checking for exit conditions
-    nodes_searched++;
+    increment(counters.nodes);
 
     move16 tt_move = NULL_MOVE;
     int s_eval;
@@ -307,10 +467,16 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
     NodeType node_type;
     int tt_depth;
     int tt_score;
-    bool tt_pv;
+    bool tt_pv = false;
 
     // Probe the transposition table
-    if ((tt_hit = tt->probe(pos.z_key, tt_move, node_type, tt_depth, tt_score, s_eval, tt_pv))) {
+    if ((tt_hit = probeTT(pos.z_key, tt_move, node_type, tt_depth, tt_score, s_eval, tt_pv))) {
+        increment(counters.tt_hits);
+
+        if constexpr (TRACK_TT_STATS) {
+            if (tt_move && !isLegal(tt_move, pos)) tt->recordFalseHit();
+        }
+
         // adjust checkmate scores according to our ply
         if (tt_score > MATE_THRESHOLD) {
             tt_score -= ply;
@@ -327,8 +493,8 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
     }
 
     // get static evaluation for use in pruning heuristics if we didn't get it from the tt
-    if (!tt_hit) {
-        s_eval = eval(pos);
+    if (!tt_hit || s_eval == NO_EVAL) {
+        s_eval = evaluate(pos);
     }
     // update the stack (used for the improving heuristic)
     search_stack[ply].s_eval = s_eval;
@@ -401,12 +567,21 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
     int best_score = NEGATIVE_INFINITY;
     move16 best_move = NULL_MOVE;
     int num_moves = 0;
+    // moves searched or deferred so far, the position in the move order used by LMR
+    int num_ordered = 0;
     bool is_upper_bound = true;
     bool skip_quiets = false;
 
     // List of all the quiet moves that didn't cause a beta cutoff. used for updating history
     MoveList bad_quiets;
 
+    // ABDADA: moves left for last because another thread was searching them. Deterministic
+    // searches can't use it, the flags are writes to the shared TT
+    bool use_abdada = abdada && !sync && depth >= ABDADA_MIN_DEPTH;
+    std::array<DeferredMove, 256> deferred;
+    int num_deferred = 0;
+    int deferred_index = -1;
+
     // reset the killer moves for the child nodes
     killer_1[ply + 1] = NULL_MOVE;
     killer_2[ply + 1] = NULL_MOVE;
@@ -429,17 +604,34 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
         */
         if (allow_fprune && !skip_quiets && best_score > -MATE_THRESHOLD) skip_quiets = true;
 
-        // get the next move from the move picker
-        skip_quiets ? move = move_picker.getNextCapture() : move = move_picker.getNextMove();
-        // break if there is no next move
-        if (!move) break;
+        // get the next move from the move picker, then the deferred moves
+        if (deferred_index < 0) {
+            skip_quiets ? move = move_picker.getNextCapture() : move = move_picker.getNextMove();
+            if (!move) deferred_index = 0;
+        }
+        /*
+        Deferred moves keep their place in the move order for LMR and late move pruning. They
+        already passed the pruning, and skip_quiets set since then came from moves ordered after
+        them, so they are always searched.
+        */
+        bool is_deferred = deferred_index >= 0;
+        int move_index = num_ordered + 1;
+        int num_quiets = bad_quiets.size();
+        if (is_deferred) {
+            if (deferred_index == num_deferred) break;
+            move = deferred[deferred_index].move;
+            move_index = deferred[deferred_index].move_index;
+            num_quiets = deferred[deferred_index].num_quiets;
+            deferred_index++;
+        }
 
         /*
         SEE pruning
 
-        at low depths prune moves determined as losing by the static exchange evaluator
+        at low depths prune moves determined as losing by the static exchange evaluator.
+        Deferred moves already passed this
         */
-        if (best_score > -MATE_THRESHOLD && !in_check && depth <= 7 &&
+        if (!is_deferred && best_score > -MATE_THRESHOLD && !in_check && depth <= 7 &&
             !seeGe(pos, move, -50 - 150 * !isQuiet(move) - 100 * improving))
             continue;
 
@@ -457,14 +649,32 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
 
         prune late-ordered quiet moves in non-PV nodes at low depth
         */
-        if (!pv_node && !skip_quiets && !in_check && depth <= 7 &&
-            static_cast<int>(bad_quiets.size()) > 1 + depth * 2 + 3 * improving && isQuiet(move) &&
-            !inCheck(pos)) {
+        if (!pv_node && !skip_quiets && !is_deferred && !in_check && depth <= 7 &&
+            num_quiets > 1 + depth * 2 + 3 * improving && isQuiet(move) && !inCheck(pos)) {
             pos.unmakeMove();
             skip_quiets = true;
             continue;
         }
 
+        /*
+        ABDADA
+
+        After the first move, a move whose position another thread is already searching goes to
+        the back of the list, by when its result is probably in the TT. Otherwise we add
+        ourselves to the position's searchers while searching it.
+        */
+        bool flagged = false;
+        if (!is_deferred) num_ordered++;
+        if (use_abdada && num_moves > 0 && !is_deferred) {
+            if (tt->isSearching(pos.z_key)) {
+                pos.unmakeMove();
+                deferred[num_deferred++] = {move, move_index, num_quiets};
+                continue;
+            }
+            tt->addSearcher(pos.z_key);
+            flagged = true;
+        }
+
         // increase the move counter only for moves that aren't pruned
         num_moves++;
         int score = 0;
@@ -478,10 +688,10 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
         be good
         */
         bool do_full_search = true;
-        if (bad_quiets.size() > 1 && depth > 2 && !in_check &&
+        if (num_quiets > 1 && depth > 2 && !in_check &&
             (!pv_node || !isCaptureOrPromotion(move))) {
             // get pre-calculated reduction from the table
-            int lmr_reduction = lmr_table[depth][num_moves];
+            int lmr_reduction = lmr_table[depth][move_index];
 
             lmr_reduction -= tt_pv;
 
@@ -531,6 +741,7 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
             }
         }
 
+        if (flagged) tt->removeSearcher(pos.z_key);
         pos.unmakeMove();
 
         // check for timeout to avoid storing bad values in the TT
@@ -555,7 +766,7 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
                     }
                 }
                 // Store to TT as a fail high
-                tt->save(pos.z_key, depth, ply, move, score, LOWER_BOUND_NODE, s_eval, pv_node);
+                saveTT(pos.z_key, depth, ply, move, score, LOWER_BOUND_NODE, s_eval, pv_node);
                 // beta cutoff
                 return score;
             } else if (score > alpha) {
@@ -580,9 +791,9 @@ int Search::negaMax(Position &pos, int depth, int ply, int alpha, int beta) {
     // save to TT as an upper bound node or an exact node depending on if we raised alpha
     if (is_upper_bound) {
         // re-use the old TT move in fail lows
-        tt->save(pos.z_key, depth, ply, tt_move, best_score, UPPER_BOUND_NODE, s_eval, pv_node);
+        saveTT(pos.z_key, depth, ply, tt_move, best_score, UPPER_BOUND_NODE, s_eval, pv_node);
     } else {
-        tt->save(pos.z_key, depth, ply, best_move, best_score, EXACT_NODE, s_eval, pv_node);
+        saveTT(pos.z_key, depth, ply, best_move, best_score, EXACT_NODE, s_eval, pv_node);
     }
 
     return best_score;
@@ -594,11 +805,15 @@ int Search::qSearch(Position &pos, int depth, int ply, int alpha, int beta) {
         return 0;
     }
     // check ply limit
-    if (ply >= MAX_PLY - 1) return eval(pos);
+    if (ply >= MAX_PLY - 1) return eval(pos, &pawn_table, &material_table);
 
     pv.zeroLength(ply);
-    nodes_searched++;
-    q_nodes++;
+    increment(counters.nodes);
+    increment(counters.q_nodes);
+    // the main search always ends in qsearch, so the deepest ply is seen here
+    if (ply + 1 > counters.sel_depth.load(std::memory_order_relaxed)) {
+        counters.sel_depth.store(ply + 1, std::memory_order_relaxed);
+    }
 
     bool in_check = inCheck(pos);
 
@@ -607,12 +822,18 @@ int Search::qSearch(Position &pos, int depth, int ply, int alpha, int beta) {
     NodeType node_type;
     int tt_depth;
     int tt_score;
-    bool tt_pv;
+    bool tt_pv = false;
     // our quiescence search static eval. used as a lower bound for our score
     int stand_pat;
 
     // Probe the transposition table
-    if ((tt_hit = tt->probe(pos.z_key, tt_move, node_type, tt_depth, tt_score, stand_pat, tt_pv))) {
+    if ((tt_hit = probeTT(pos.z_key, tt_move, node_type, tt_depth, tt_score, stand_pat, tt_pv))) {
+        increment(counters.tt_hits);
+
+        if constexpr (TRACK_TT_STATS) {
+            if (tt_move && !isLegal(tt_move, pos)) tt->recordFalseHit();
+        }
+
         // adjust checkmate scores according to our ply
         if (tt_score > MATE_THRESHOLD) {
             tt_score -= ply;
@@ -631,8 +852,8 @@ int Search::qSearch(Position &pos, int depth, int ply, int alpha, int beta) {
     // don't use standing pat when in check. (we need to search evasions)
     if (in_check) {
         stand_pat = NEGATIVE_INFINITY;
-    } else if (!tt_hit) {
-        stand_pat = eval(pos);
+    } else if (!tt_hit || stand_pat == NO_EVAL) {
+        stand_pat = evaluate(pos);
     }
 
     bool is_upper_bound = true;
@@ -678,7 +899,8 @@ int Search::qSearch(Position &pos, int depth, int ply, int alpha, int beta) {
             best_score = score;
             best_move = move;
             if (score >= beta) {
-                tt->save(pos.z_key, depth, ply, move, score, LOWER_BOUND_NODE, stand_pat, false);
+                saveTT(pos.z_key, depth, ply, move, score, LOWER_BOUND_NODE, stand_pat, false,
+                       true);
                 return score;
             } else if (score > alpha) {
                 alpha = score;
@@ -697,9 +919,11 @@ int Search::qSearch(Position &pos, int depth, int ply, int alpha, int beta) {
     }
 
     if (is_upper_bound) {
-        tt->save(pos.z_key, depth, ply, tt_move, best_score, UPPER_BOUND_NODE, stand_pat, false);
+        saveTT(pos.z_key, depth, ply, tt_move, best_score, UPPER_BOUND_NODE, stand_pat, false,
+               true);
     } else {
-        tt->save(pos.z_key, depth, ply, best_move, best_score, EXACT_NODE, stand_pat, false);
+        saveTT(pos.z_key, depth, ply, best_move, best_score, EXACT_NODE, stand_pat, false,
+               true);
     }
 
     return best_score;
@@ -2,11 +2,16 @@
 
 #include <array>
 #include <atomic>
+#include <barrier>
 #include <chrono>
-#include <functional>
+#include <memory>
+#include <vector>
 
 #include "eval.hpp"
+#include "evalcache.hpp"
+#include "material.hpp"
 #include "movegen.hpp"
+#include "pawns.hpp"
 #include "position.hpp"
 #include "see.hpp"
 #include "tt.hpp"
@@ -22,6 +27,24 @@ const int WINDOW_SIZE = 10;
 const int WINDOW_INCREMENT = 60;
 const int FUTILITY_MARGIN = 120;
 
+// nodes a thread takes from a shared node budget at a time
+const int64_t NODE_BATCH_SIZE = 1024;
+
+// ABDADA only defers moves at this depth and above, below it flagging costs more than it saves
+const int ABDADA_MIN_DEPTH = 4;
+
+// a move ABDADA put off, with where it came in the move order for LMR and late move pruning
+struct DeferredMove {
+    move16 move;
+    int move_index;
+    int num_quiets;
+};
+
+// size of each thread's private TT in deterministic mode
+const size_t DETERMINISTIC_TT_SIZE = 4 * 1024 * 1024;
+// TT writes a thread logs per iteration in deterministic mode, later ones only go to its own TT
+const size_t DETERMINISTIC_LOG_SIZE = 1 << 18;
+
 class PVTable {
    public:
     std::array<std::array<move16, MAX_PLY>, MAX_PLY> table;
@@ -43,6 +66,88 @@ class PVTable {
 struct SearchResult {
     move16 move;
     int score;
+    // last fully searched iteration, 0 if none finished
+    int depth;
+};
+
+/*
+Lazy SMP depth staggering: helper thread i skips an iteration when
+((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) is odd, using the tables cyclically from the first
+helper. Helpers then spread over neighbouring depths instead of all searching the main thread's.
+*/
+constexpr int SKIP_TABLE_SIZE = 20;
+constexpr int SKIP_SIZE[SKIP_TABLE_SIZE] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                            3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr int SKIP_PHASE[SKIP_TABLE_SIZE] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+                                             4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+inline bool skipDepth(int thread_id, int depth) {
+    if (thread_id == 0) return false;
+    int i = (thread_id - 1) % SKIP_TABLE_SIZE;
+    return ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2;
+}
+
+// picks between the results of the threads of one search, see Threads::finishMainThread
+SearchResult voteBestResult(const std::vector<SearchResult>& results);
+
+/*
+Per-thread search statistics. Only the owning thread writes them, the other threads read them for
+the node total and info output, so relaxed atomics are enough. Each block sits on its own cache
+line so the hot counters of neighbouring threads don't false share.
+*/
+struct alignas(64) SearchCounters {
+    std::atomic<U64> nodes{0};
+    std::atomic<U64> q_nodes{0};
+    std::atomic<U64> tt_hits{0};
+    std::atomic<int> sel_depth{0};
+
+    void clear();
+};
+
+// single writer, so a relaxed load and store does instead of a locked add
+inline void increment(std::atomic<U64>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// a TT write held back until the end of the iteration in deterministic mode
+struct TTWrite {
+    U64 z_key;
+    int depth;
+    int ply;
+    move16 move;
+    int score;
+    NodeType node_type;
+    int s_eval;
+    bool is_pv;
+};
+
+/*
+Lockstep iterations for deterministic multi-threaded searches. During an iteration the shared TT
+is only read: every thread saves to its own small TT, which it probes first, and logs the write.
+Once all threads have finished the iteration the logs are replayed into the shared TT in thread
+order. What a thread sees then depends only on node counts, never on timing, so with node or
+depth limits the whole search repeats exactly.
+*/
+class SearchSync {
+   public:
+    SearchSync(TT* _tt, std::vector<std::vector<TTWrite>*> _logs);
+
+    // waits for the other threads to finish the iteration, true when the search should end
+    bool endIteration();
+    // a thread that has stopped searching, the search ends once the main thread leaves
+    void leave(int thread_id);
+
+   private:
+    struct MergeLogs {
+        SearchSync* sync;
+        void operator()() noexcept;
+    };
+
+    TT* tt;
+    std::vector<std::vector<TTWrite>*> logs;
+    std::atomic<bool> main_done;
+    bool stop;
+    std::barrier<MergeLogs> barrier;
 };
 
 struct StackEntry {
@@ -53,28 +158,64 @@ struct StackEntry {
 
 class Search {
    public:
-    Search(TT* _tt, std::atomic<bool>* _is_stopped, std::function<U64()> _getNodes);
+    // thread_counters holds the counters of every thread searching together, for the node
+    // total. Without it only this search's own nodes are counted
+    Search(TT* _tt, std::atomic<bool>* _is_stopped,
+           const std::vector<const SearchCounters*>* _thread_counters = nullptr);
 
     SearchResult timeSearch(Position& pos, int max_depth, U64 time_in_ms);
-    SearchResult nodeSearch(Position& pos, int max_depth, U64 num_nodes);
+    // with a node_pool the threads share one budget, num_nodes is then ignored
+    SearchResult nodeSearch(Position& pos, int max_depth, U64 num_nodes,
+                            std::atomic<int64_t>* node_pool = nullptr);
     int qScore(Position& pos);
     void clearTT();
     void clearHistory();
-    int tt_hits;
-    U64 nodes_searched;
-    U64 q_nodes;
+    U64 totalNodes() const;
+    // allocates or frees the private TT used in deterministic mode
+    void setDeterministic(bool enabled);
+    SearchCounters counters;
     bool make_output;
+    // ABDADA instead of Lazy SMP, set by Threads
+    bool abdada;
+    PawnTable pawn_table;
+    MaterialTable material_table;
+    EvalCache eval_cache;
 
     int thread_id;
     std::atomic<bool>* is_stopped;
-    std::function<U64()> getNodes;
+    const std::vector<const SearchCounters*>* thread_counters;
+    // set for deterministic searches, see SearchSync
+    SearchSync* sync;
+    std::unique_ptr<TT> local_tt;
+    std::vector<TTWrite> tt_log;
 
    private:
     void setTimer(U64 duration_in_ms, int interval);
     template <bool pv_node, bool cut_node, bool is_root>
     int negaMax(Position& pos, int depth, int ply, int alpha, int beta);
     int qSearch(Position& pos, int depth, int ply, int alpha, int beta);
+    int evaluate(Position& pos);
+    inline bool probeTT(U64 z_key, move16& tt_move, NodeType& node_type, int& depth, int& score,
+                        int& s_eval, bool& tt_pv) {
+        if (sync && local_tt->probe(z_key, tt_move, node_type, depth, score, s_eval, tt_pv)) {
+            return true;
+        }
+        return tt->probe(z_key, tt_move, node_type, depth, score, s_eval, tt_pv);
+    }
+    // qsearch entries are cheap to redo, so deterministic searches keep them in the private TT
+    inline void saveTT(U64 z_key, int depth, int ply, move16 move, int score, NodeType node_type,
+                       int s_eval, bool is_pv, bool is_qsearch = false) {
+        if (sync) {
+            local_tt->save(z_key, depth, ply, move, score, node_type, s_eval, is_pv);
+            if (!is_qsearch && tt_log.size() < DETERMINISTIC_LOG_SIZE) {
+                tt_log.push_back({z_key, depth, ply, move, score, node_type, s_eval, is_pv});
+            }
+            return;
+        }
+        tt->save(z_key, depth, ply, move, score, node_type, s_eval, is_pv);
+    }
     bool timesUp();
+    bool reserveNodes();
     bool softTimesUp();
     SearchResult iterSearch(Position& pos, int max_depth);
     void outputInfo(int depth, move16 best_move, int score);
@@ -96,6 +237,7 @@ class Search {
     int time_check;
     int time_check_interval;
     U64 max_nodes;
+    std::atomic<int64_t>* node_pool;
 
     move16 killer_1[MAX_PLY];
     move16 killer_2[MAX_PLY];
@@ -1,15 +1,35 @@
 #include "test.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <cassert>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "move.hpp"
 #include "movegen.hpp"
 #include "movepicker.hpp"
+#include "nnue.hpp"
+#include "endgame.hpp"
+#include "eval.hpp"
+#include "evalbatch.hpp"
 #include "position.hpp"
 #include "search.hpp"
 #include "see.hpp"
+#include "threads.hpp"
+#include "tt.hpp"
 #include "utils.hpp"
 
 namespace Spotlight {
@@ -46,6 +66,18 @@ void runTests() {
     testSee();
     testPerft();
     testCheck();
+    testTTConcurrency();
+    testSharedTT();
+    testNNUE();
+    testEvalFile();
+    testPawnStructure();
+    testEvalTrace();
+    testEvalBatch();
+    testMaterial();
+    testKPK();
+    testNodeBudget();
+    testDeterministic();
+    testSearchers();
 
     std::cout << "Tests Passed" << std::endl;
 }
@@ -175,7 +207,7 @@ void testSearch() {
     TT tt;
     std::atomic<bool> is_stopped(false);
 
-    Search search(&tt, &is_stopped, [&search]() { return search.nodes_searched; });
+    Search search(&tt, &is_stopped);
 
     U64 nodes = 0ULL;
     U64 q_nodes = 0ULL;
@@ -188,8 +220,8 @@ void testSearch() {
         pos.readFen(fen);
         SearchResult r = search.timeSearch(pos, 15, 100000ULL);
         std::cout << "result move" << r.move << "\n";
-        nodes += search.nodes_searched;
-        q_nodes += search.q_nodes;
+        nodes += search.counters.nodes.load();
+        q_nodes += search.counters.q_nodes.load();
     }
 
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
@@ -202,6 +234,141 @@ void testSearch() {
               << " quiescence nodes\n";
 }
 
+// fixed depth (or fixed node) search over the test positions, reporting speed and TT hit rate
+void bench(int hash_mb, int depth, U64 nodes_per_position, size_t eval_cache_mb) {
+    Position pos;
+    TT tt(static_cast<size_t>(hash_mb) * 1024 * 1024);
+    std::atomic<bool> is_stopped(false);
+
+    Search search(&tt, &is_stopped);
+    search.make_output = false;
+    search.eval_cache.resize(eval_cache_mb);
+
+    U64 nodes = 0ULL;
+    U64 tt_hits = 0ULL;
+    U64 tt_probes = 0ULL;
+    U64 false_hits = 0ULL;
+    std::chrono::milliseconds elapsed_time(0);
+
+    for (const auto &fen : TEST_POSITIONS) {
+        search.clearHistory();
+        tt.clear();
+        pos.readFen(fen);
+
+        // only time the search itself so clearing large tables doesn't skew the result
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (nodes_per_position) {
+            search.nodeSearch(pos, depth, nodes_per_position);
+        } else {
+            search.timeSearch(pos, depth, 999999999ULL);
+        }
+        elapsed_time += std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        nodes += search.counters.nodes.load();
+        tt_hits += search.counters.tt_hits.load();
+        tt_probes += tt.stats.probes.load();
+        false_hits += tt.stats.false_hits.load();
+    }
+
+    U64 nps = nodes * 1000 / std::max(static_cast<int64_t>(elapsed_time.count()), int64_t(1));
+
+    std::cout << nodes << " nodes searched at " << nps << " nps, tt hit rate "
+              << static_cast<double>(tt_hits) * 100.0 / nodes << "%, pawn hit rate "
+              << static_cast<double>(search.pawn_table.hits) * 100.0 /
+                     std::max(search.pawn_table.probes, U64(1))
+              << "%, eval cache hit rate "
+              << static_cast<double>(search.eval_cache.hits) * 100.0 /
+                     std::max(search.eval_cache.probes, U64(1))
+              << "%";
+    if constexpr (TRACK_TT_STATS) {
+        std::cout << ", " << static_cast<double>(false_hits) * 1000000.0 / tt_probes
+                  << " false hits per million probes";
+    }
+    std::cout << "\n";
+}
+
+/*
+Time and nodes to depth on the bench positions for 1, 2, 4 ... max_threads threads, with Lazy SMP
+and ABDADA. Time to depth is the usual way to judge a parallel search since nps alone says
+nothing about how useful the extra nodes are.
+*/
+void benchSMP(int hash_mb, int depth, int max_threads) {
+    const int num_positions = 8;
+    double base_time = 0.0;
+
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        for (ParallelMode mode : {LAZY_SMP, ABDADA}) {
+            // both modes are the same search with one thread
+            if (num_threads == 1 && mode == ABDADA) continue;
+
+            Threads threads(num_threads);
+            threads.setOutput(false);
+            threads.setParallelMode(mode);
+            threads.tt.resize(static_cast<size_t>(hash_mb) * 1024 * 1024);
+
+            U64 nodes = 0ULL;
+            std::chrono::duration<double> elapsed(0.0);
+            Position pos;
+            for (int i = 0; i < num_positions; i++) {
+                threads.newGame();
+                pos.readFen(TEST_POSITIONS[i]);
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                threads.depthSearch(pos, depth);
+                threads.finishSearch();
+                elapsed += std::chrono::steady_clock::now() - start;
+                nodes += threads.getNodes();
+            }
+
+            if (num_threads == 1) base_time = elapsed.count();
+            std::cout << num_threads << " threads " << (mode == ABDADA ? "abdada" : "lazy smp")
+                      << ": depth " << depth << " in " << elapsed.count() << "s, " << nodes
+                      << " nodes, " << static_cast<U64>(nodes / elapsed.count())
+                      << " nps, speedup " << base_time / elapsed.count() << std::endl;
+        }
+    }
+}
+
+// TT probe/save throughput with random keys, half of the probes being hits
+void benchTT(int hash_mb) {
+    const U64 num_keys = 1 << 20;
+    const U64 num_probes = 50000000;
+
+    TT tt(static_cast<size_t>(hash_mb) * 1024 * 1024);
+    std::mt19937_64 rng(1);
+    std::vector<U64> keys(num_keys);
+
+    for (auto &key : keys) {
+        key = rng();
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (U64 i = 0; i < num_keys; i += 2) {
+        tt.save(keys[i], 1, 0, 0, 0, EXACT_NODE, 0, false);
+    }
+
+    std::chrono::duration<double> save_time = std::chrono::steady_clock::now() - start;
+
+    move16 tt_move;
+    NodeType node_type;
+    int depth, score, s_eval;
+    bool tt_pv;
+    U64 hits = 0ULL;
+
+    start = std::chrono::steady_clock::now();
+
+    for (U64 i = 0; i < num_probes; i++) {
+        hits += tt.probe(keys[i & (num_keys - 1)], tt_move, node_type, depth, score, s_eval, tt_pv);
+    }
+
+    std::chrono::duration<double> probe_time = std::chrono::steady_clock::now() - start;
+
+    std::cout << static_cast<U64>(num_keys / 2 / save_time.count()) << " saves/s, "
+              << static_cast<U64>(num_probes / probe_time.count()) << " probes/s, " << hits
+              << " hits\n";
+}
+
 void testMovePicker() {
     Position pos;
     int hist[2][64][64];
@@ -328,4 +495,496 @@ void testMoveVerification() {
     assert(n == 48);
 }
 
+/*
+Hammer a small TT from many threads. Every entry saved for a key has fields derived from that
+key, so any probe hit with fields that don't match its key is a torn or corrupted read.
+*/
+void testTTConcurrency() {
+    const int num_threads = 32;
+    const int iterations = 200000;
+    const U64 num_keys = 4096;
+
+    TT tt(64 * 1024);
+    std::atomic<U64> corrupted(0ULL);
+    std::atomic<U64> hits(0ULL);
+    std::vector<std::thread> threads;
+
+    auto expectedMove = [](U64 key) { return static_cast<move16>(key >> 20); };
+    auto expectedScore = [](U64 key) { return static_cast<int>(key % 2000) - 1000; };
+    auto expectedEval = [](U64 key) { return static_cast<int>((key >> 32) % 2000) - 1000; };
+    auto expectedDepth = [](U64 key) { return static_cast<int>((key >> 8) % 60); };
+
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 rng(t);
+            U64 local_corrupted = 0ULL;
+            U64 local_hits = 0ULL;
+
+            for (int i = 0; i < iterations; i++) {
+                // every thread draws from the same small set of keys to maximise contention
+                U64 key = (rng() % num_keys + 1) * 0x9E3779B97F4A7C15ULL;
+                key ^= key >> 29;
+
+                if (rng() & 1) {
+                    tt.save(key, expectedDepth(key), 0, expectedMove(key), expectedScore(key),
+                            EXACT_NODE, expectedEval(key), false);
+                } else {
+                    move16 tt_move;
+                    NodeType node_type;
+                    int depth, score, s_eval;
+                    bool tt_pv;
+                    if (tt.probe(key, tt_move, node_type, depth, score, s_eval, tt_pv)) {
+                        local_hits++;
+                        if (tt_move != expectedMove(key) || score != expectedScore(key) ||
+                            (TT_STORES_EVAL && s_eval != expectedEval(key)) ||
+                            depth != expectedDepth(key) || node_type != EXACT_NODE || tt_pv) {
+                            local_corrupted++;
+                        }
+                    }
+                }
+            }
+
+            corrupted += local_corrupted;
+            hits += local_hits;
+        });
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    std::cout << "TT concurrency: " << hits.load() << " hits, " << corrupted.load()
+              << " corrupted reads\n";
+    assert(corrupted.load() == 0ULL);
+}
+
+/*
+Search the same position to the same depth from two processes sharing one TT. The second
+process should get there in far fewer nodes by reusing the first one's entries.
+*/
+void testSharedTT() {
+#if defined(__linux__)
+    const int depth = 13;
+    const std::string name = "/spotlight_test_" + std::to_string(getpid());
+    const char *fen = TEST_POSITIONS[1];
+
+    auto searchShared = [&]() {
+        TT tt(16 * 1024 * 1024);
+        tt.setShared(name);
+        assert(tt.isShared());
+        std::atomic<bool> is_stopped(false);
+        Search search(&tt, &is_stopped);
+        search.make_output = false;
+        Position pos;
+        pos.readFen(fen);
+        search.timeSearch(pos, depth, 999999999ULL);
+        return search.counters.nodes.load();
+    };
+
+    int fds[2];
+    int piped = pipe(fds);
+    assert(piped == 0);
+
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        close(fds[0]);
+        U64 nodes = searchShared();
+        ssize_t written = write(fds[1], &nodes, sizeof(nodes));
+        close(fds[1]);
+        _exit(written == sizeof(nodes) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    U64 first_nodes = 0ULL;
+    ssize_t bytes_read = read(fds[0], &first_nodes, sizeof(first_nodes));
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    assert(bytes_read == sizeof(first_nodes) && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    U64 second_nodes = searchShared();
+    shm_unlink(name.c_str());
+
+    std::cout << "Shared TT: first process " << first_nodes << " nodes, second process "
+              << second_nodes << " nodes to depth " << depth << "\n";
+    assert(second_nodes < first_nodes);
+#endif
+}
+
+// walk the tree to a small depth checking the incremental accumulators against a refresh
+static void checkAccumulators(Position &pos, int depth) {
+    Position fresh;
+    fresh.readFen(pos.toFen());
+    assert(std::equal(&fresh.accumulators.back().values[0][0],
+                      &fresh.accumulators.back().values[0][0] + 2 * NNUE_HIDDEN,
+                      &pos.accumulators.back().values[0][0]));
+    assert(eval(fresh) == eval(pos));
+
+    if (depth == 0) return;
+
+    MoveList moves;
+    generateMoves(moves, pos);
+    for (auto &sm : moves) {
+        pos.makeMove(sm.move);
+        checkAccumulators(pos, depth - 1);
+        pos.unmakeMove();
+    }
+}
+
+void testNNUE() {
+    // no net ships with the engine so test against random weights, restoring whatever was loaded
+    auto saved = std::make_unique<Network>(network);
+    bool saved_loaded = network_loaded;
+    bool saved_enabled = nnue_enabled;
+
+    U64 state = 0x9e3779b97f4a7c15ULL;
+    auto next = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    for (auto &w : network.feature_weights) w = static_cast<int16_t>(next() % 129) - 64;
+    for (auto &b : network.feature_bias) b = static_cast<int16_t>(next() % 129) - 64;
+    for (auto &w : network.output_weights) w = static_cast<int16_t>(next() % 255) - 127;
+    network.output_bias = 17;
+    network_loaded = true;
+    nnue_enabled = true;
+
+    Position pos;
+    assert(pos.use_nnue);
+
+    // the eval should be symmetric between a position and its colour flipped mirror
+    pos.readFen("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+    int original = eval(pos);
+    pos.readFen("rnbqkb1r/pppp1ppp/5n2/4p3/4P3/2N5/PPPP1PPP/R1BQKBNR b KQkq - 2 3");
+    assert(eval(pos) == original);
+
+    for (int i = 0; i < 4; i++) {
+        pos.readFen(TEST_POSITIONS[i]);
+        checkAccumulators(pos, 2);
+    }
+
+    network = *saved;
+    network_loaded = saved_loaded;
+    nnue_enabled = saved_enabled;
+
+    std::cout << "NNUE accumulators match" << std::endl;
+}
+
+void testEvalFile() {
+    const std::string path = "./test_eval_params.tmp";
+    Position pos;
+    pos.readFen("4k3/pppp4/8/8/8/8/PPPPPP2/4K3 w - - 0 1");
+    int default_eval = eval(pos);
+
+    // two extra white pawns, so a pawn worth 10 more shifts the eval by 20 in every phase
+    EvalParams params = default_eval_params;
+    params.piece_values[PAWN] += S(10, 10);
+    bool written = writeEvalFile(path, params);
+    assert(written);
+    bool loaded = loadEvalFile(path);
+    assert(loaded);
+    pos.refreshScores();
+    assert(eval(pos) == default_eval + 20);
+    assert(eval(pos) == evalFromScratch(pos));
+
+    // flip a byte in the params, the checksum should reject it and keep the loaded params
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(sizeof(EvalFileHeader) + 100);
+        file.put(0x7f);
+    }
+    loaded = loadEvalFile(path);
+    assert(!loaded);
+    assert(eval(pos) == default_eval + 20);
+
+    useDefaultEvalParams();
+    pos.refreshScores();
+    assert(eval(pos) == default_eval);
+    std::remove(path.c_str());
+
+    std::cout << "Eval file round trip passed" << std::endl;
+}
+
+void testPawnStructure() {
+    Position pos;
+
+    // white: doubled isolated a-pawns and a passed e-pawn on the 6th, black: a lone h-pawn
+    pos.readFen("4k3/7p/4P3/8/8/P7/P7/4K3 w - - 0 1");
+    Score expected = doubled_pawn + 3 * isolated_pawn + passed_pawn[2] + passed_pawn[5] -
+                     (isolated_pawn + passed_pawn[1]);
+    assert(evalPawnStructure(pos) == expected);
+
+    // the pawn key follows captures, promotions and en passant, and the table returns the same
+    // score as a direct computation
+    PawnTable pawn_table;
+    pos.readFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - ");
+    MoveList moves;
+    generateMoves(moves, pos);
+    for (auto &sm : moves) {
+        pos.makeMove(sm.move);
+        MoveList replies;
+        generateMoves(replies, pos);
+        for (auto &reply : replies) {
+            pos.makeMove(reply.move);
+            assert(pos.pawn_key == pos.generatePawnKey());
+            assert(pawn_table.probe(pos) == evalPawnStructure(pos));
+            pos.unmakeMove();
+        }
+        pos.unmakeMove();
+    }
+    assert(pawn_table.hits > 0);
+
+    std::cout << "Pawn structure passed, pawn hit rate "
+              << static_cast<double>(pawn_table.hits) * 100.0 / pawn_table.probes << "%"
+              << std::endl;
+}
+
+// tracing must not change the eval, and should count every piece once in the psqt terms
+void testEvalTrace() {
+    Position pos;
+    for (const auto &fen : TEST_POSITIONS) {
+        pos.readFen(fen);
+        EvalTrace trace;
+        assert(evalFromScratch(pos, trace) == eval(pos));
+        assert(trace.phase == computeMaterial(pos.bitboards).phase);
+
+        int pieces[2] = {0, 0};
+        for (int term = TERM_PSQT; term < TERM_PASSED_PAWN; term++) {
+            pieces[WHITE] += trace.coeffs[term][WHITE];
+            pieces[BLACK] += trace.coeffs[term][BLACK];
+        }
+        assert(pieces[WHITE] == countBits(pos.bitboards[WHITE_OCCUPANCY]));
+        assert(pieces[BLACK] == countBits(pos.bitboards[BLACK_OCCUPANCY]));
+    }
+
+    std::cout << "Eval trace matches eval" << std::endl;
+}
+
+// batched scores must match eval() whether boards come from positions or fens
+void testEvalBatch() {
+    std::vector<Position> positions(TEST_POSITIONS.size() * 20);
+    std::vector<int> scores(positions.size());
+    auto batch = std::make_unique<EvalBatch>();
+    std::vector<int> fen_scores(TEST_POSITIONS.size());
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        positions[i].readFen(TEST_POSITIONS[i % TEST_POSITIONS.size()]);
+    }
+    evalBatch(positions, scores);
+    for (size_t i = 0; i < positions.size(); i++) {
+        assert(scores[i] == eval(positions[i]));
+    }
+
+    for (const auto &fen : TEST_POSITIONS) {
+        bool added = batch->addFen(fen);
+        assert(added);
+    }
+    // a bad piece letter is rejected without adding anything
+    bool added = batch->addFen("4k3/8/8/8/8/8/8/4K2X w - - 0 1");
+    assert(!added && batch->size() == static_cast<int>(TEST_POSITIONS.size()));
+    // as is a board without exactly one king each
+    added = batch->addFen("8/8/8/8/8/8/8/4K2R w - - 0 1");
+    assert(!added && batch->size() == static_cast<int>(TEST_POSITIONS.size()));
+    batch->evaluate(fen_scores.data());
+    for (size_t i = 0; i < TEST_POSITIONS.size(); i++) {
+        assert(fen_scores[i] == scores[i]);
+    }
+
+    std::cout << "Batch eval matches eval" << std::endl;
+}
+
+// endgame dispatch by material, and the material key following captures and promotions
+void testMaterial() {
+    Position pos;
+
+    pos.readFen("8/8/8/4k3/8/8/8/KBN5 w - - 0 1");
+    assert(computeMaterial(pos.bitboards).endgame == evalKBNK<WHITE>);
+    int centre = eval(pos);
+    assert(centre > KNOWN_WIN);
+    // the weak king is worse off in the corner of the bishop's colour than the other one
+    pos.readFen("k7/8/8/8/8/8/8/KBN5 w - - 0 1");
+    int right_corner = eval(pos);
+    pos.readFen("7k/8/8/8/8/8/8/KBN5 w - - 0 1");
+    assert(right_corner > eval(pos) && right_corner > centre);
+
+    pos.readFen("8/8/8/4k3/8/8/8/K2r4 w - - 0 1");
+    assert(computeMaterial(pos.bitboards).endgame == evalKXK<BLACK>);
+    assert(eval(pos) < -KNOWN_WIN);
+
+    for (const char *fen : {"8/8/4k3/8/8/8/8/KN3b2 w - - 0 1", "8/8/4k3/8/8/8/8/KNN5 b - - 0 1"}) {
+        pos.readFen(fen);
+        assert(eval(pos) == 0);
+    }
+
+    // opposite coloured bishops halve the endgame part, same coloured ones don't
+    pos.readFen("8/4k3/8/3b4/8/4B3/PP6/K7 w - - 0 1");
+    assert(scaleOppositeBishops(pos.bitboards) < SCALE_NORMAL);
+    pos.readFen("8/4k3/8/4b3/8/4B3/PP6/K7 w - - 0 1");
+    assert(scaleOppositeBishops(pos.bitboards) == SCALE_NORMAL);
+
+    MaterialTable material_table;
+    pos.readFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - ");
+    MoveList moves;
+    generateMoves(moves, pos);
+    for (auto &sm : moves) {
+        pos.makeMove(sm.move);
+        MoveList replies;
+        generateMoves(replies, pos);
+        for (auto &reply : replies) {
+            pos.makeMove(reply.move);
+            assert(pos.material_key == generateMaterialKey(pos.bitboards));
+            assert(material_table.probe(pos)->phase == computeMaterial(pos.bitboards).phase);
+            pos.unmakeMove();
+        }
+        pos.unmakeMove();
+    }
+    assert(material_table.hits > 0);
+
+    std::cout << "Material and endgames passed" << std::endl;
+}
+
+// swaps the colours and mirrors the board both ways, for fens without castling or en passant
+static std::string flipFen(const std::string &fen) {
+    std::istringstream fen_stream(fen);
+    std::string board, side, rest;
+    fen_stream >> board >> side;
+    std::getline(fen_stream, rest);
+
+    std::string flipped;
+    for (auto it = board.rbegin(); it != board.rend(); it++) {
+        char c = *it;
+        flipped += std::isupper(c) ? std::tolower(c) : std::toupper(c);
+    }
+    return flipped + (side == "w" ? " b" : " w") + rest;
+}
+
+// a few textbook king and pawn endings, each checked from both sides of the board
+void testKPK() {
+    struct KPKCase {
+        const char *fen;
+        bool win;
+    };
+    const KPKCase cases[] = {
+        // king on the sixth in front of the pawn wins whoever moves
+        {"4k3/8/4K3/4P3/8/8/8/8 w - - 0 1", true},
+        {"4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", true},
+        // with the king two squares ahead of the pawn the opposition decides it
+        {"4k3/8/8/4K3/4P3/8/8/8 w - - 0 1", true},
+        {"4k3/8/8/4K3/4P3/8/8/8 b - - 0 1", false},
+        // rook pawn with the defending king in the corner
+        {"k7/8/8/8/8/8/P7/7K w - - 0 1", false},
+        // the king catches the pawn only if it can step into its square first
+        {"8/8/8/8/P4k2/8/8/7K w - - 0 1", true},
+        {"8/8/8/8/P4k2/8/8/7K b - - 0 1", false},
+        // the pawn is lost
+        {"8/8/8/4k3/4P3/8/8/7K w - - 0 1", false},
+    };
+
+    Position pos;
+    for (const auto &test : cases) {
+        pos.readFen(test.fen);
+        int score = eval(pos);
+        int white_score = pos.side_to_move == WHITE ? score : -score;
+        assert(test.win ? white_score > KNOWN_WIN : score == 0);
+
+        // the same position with colours and ranks swapped, and mirrored across the board
+        std::string flipped = flipFen(test.fen);
+        pos.readFen(flipped);
+        assert(eval(pos) == score);
+    }
+
+    std::cout << "KPK bitbase passed" << std::endl;
+}
+
+// go nodes with several threads searches the limit in total, not per thread
+void testNodeBudget() {
+    const int num_threads = 4;
+    const U64 limit = 200000;
+
+    Threads threads(num_threads);
+    threads.setOutput(false);
+    Position pos;
+    pos.readFen(TEST_POSITIONS[1]);
+    threads.nodeSearch(pos, limit);
+    threads.finishSearch();
+
+    U64 nodes = threads.getNodes();
+    assert(nodes <= limit && nodes + num_threads * NODE_BATCH_SIZE > limit);
+
+    std::cout << "Node budget: " << nodes << " of " << limit << " nodes with " << num_threads
+              << " threads" << std::endl;
+}
+
+// deterministic mode repeats the same multi-threaded search exactly, by nodes and by depth
+void testDeterministic() {
+    Threads threads(4);
+    threads.setOutput(false);
+    threads.setDeterministic(true);
+    Position pos;
+    pos.readFen(TEST_POSITIONS[2]);
+
+    U64 nodes[2];
+    U64 thread_nodes[2][4];
+    move16 moves[2];
+    for (int run = 0; run < 2; run++) {
+        threads.newGame();
+        threads.nodeSearch(pos, 300000);
+        threads.finishSearch();
+        nodes[run] = threads.getNodes();
+        moves[run] = threads.bestResult().move;
+    }
+    assert(nodes[0] == nodes[1] && moves[0] == moves[1]);
+
+    for (int run = 0; run < 2; run++) {
+        threads.newGame();
+        threads.depthSearch(pos, 9);
+        threads.finishSearch();
+        nodes[run] = threads.getNodes();
+        moves[run] = threads.bestResult().move;
+        for (int i = 0; i < 4; i++) thread_nodes[run][i] = threads.getNodes(i);
+    }
+    assert(nodes[0] == nodes[1] && moves[0] == moves[1]);
+
+    // every thread repeats its own tree, and the helpers' trees differ from each other's
+    for (int i = 0; i < 4; i++) {
+        assert(thread_nodes[0][i] == thread_nodes[1][i]);
+        for (int j = 0; j < i; j++) assert(thread_nodes[0][i] != thread_nodes[0][j]);
+    }
+
+    std::cout << "Deterministic search repeats, " << nodes[0] << " nodes to depth 9" << std::endl;
+}
+
+// ABDADA searcher counts: placeholders for new positions, one claim per thread, kept by saves
+void testSearchers() {
+    TT tt(1024 * 1024);
+    const U64 key = 0x9d39247e33776d41ULL;
+    move16 tt_move;
+    NodeType node_type;
+    int depth, score, s_eval;
+    bool tt_pv;
+
+    tt.addSearcher(key);
+    assert(tt.isSearching(key));
+    assert(!tt.probe(key, tt_move, node_type, depth, score, s_eval, tt_pv));
+
+    tt.addSearcher(key);
+    tt.save(key, 5, 0, NULL_MOVE, 10, EXACT_NODE, 0, false);
+    assert(tt.probe(key, tt_move, node_type, depth, score, s_eval, tt_pv) && depth == 5);
+    tt.removeSearcher(key);
+    assert(tt.isSearching(key));
+    tt.removeSearcher(key);
+    assert(!tt.isSearching(key));
+    assert(tt.probe(key, tt_move, node_type, depth, score, s_eval, tt_pv) && score == 10);
+
+    // claims don't carry over into the next search
+    tt.addSearcher(key);
+    tt.nextGeneration();
+    assert(!tt.isSearching(key));
+
+    std::cout << "ABDADA searcher counts work" << std::endl;
+}
+
 }  // namespace Spotlight
@@ -5,6 +5,7 @@
 #include <string_view>
 #include <vector>
 
+#include "evalcache.hpp"
 #include "position.hpp"
 #include "types.hpp"
 
@@ -20,6 +21,13 @@ void testPerft();
 
 void testSearch();
 
+void bench(int hash_mb, int depth, U64 nodes_per_position = 0,
+           size_t eval_cache_mb = EVAL_CACHE_DEFAULT_MB);
+
+void benchTT(int hash_mb);
+
+void benchSMP(int hash_mb, int depth, int max_threads);
+
 void testMovePicker();
 
 U64 testLegalPerft(Position &pos, int depth);
@@ -28,4 +36,28 @@ U64 testLegalPerftHelper(Position &pos, int depth);
 
 void testMoveVerification();
 
+void testTTConcurrency();
+
+void testSharedTT();
+
+void testNNUE();
+
+void testEvalFile();
+
+void testPawnStructure();
+
+void testEvalTrace();
+
+void testEvalBatch();
+
+void testMaterial();
+
+void testKPK();
+
+void testNodeBudget();
+
+void testDeterministic();
+
+void testSearchers();
+
 }  // namespace Spotlight
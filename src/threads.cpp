@@ -1,19 +1,24 @@
 #include "threads.hpp"
 
+#include <iostream>
+
 #include "search.hpp"
 
 namespace Spotlight {
 
-SearchWrapper::SearchWrapper(TT* _tt, std::atomic<bool>* _is_stopped,
-                             std::function<U64()> _getNodes)
-    : search(_tt, _is_stopped, _getNodes),
+SearchWrapper::SearchWrapper(Threads* _threads, TT* _tt, std::atomic<bool>* _is_stopped,
+                             const std::vector<const SearchCounters*>* _thread_counters)
+    : search(_tt, _is_stopped, _thread_counters),
       pos(),
       node_search(false),
       max_nodes(0ULL),
+      node_pool(nullptr),
       max_depth(MAX_PLY),
       time_in_ms(0ULL),
+      result{NULL_MOVE, 0, 0},
       is_waiting(true),
-      exit_thread(false) {}
+      exit_thread(false),
+      threads(_threads) {}
 
 void SearchWrapper::wait() {
     while (true) {
@@ -25,16 +30,27 @@ void SearchWrapper::wait() {
         if (exit_thread) break;
 
         if (node_search) {
-            search.nodeSearch(pos, max_depth, max_nodes);
+            result = search.nodeSearch(pos, max_depth, max_nodes, node_pool);
         } else {
-            search.timeSearch(pos, max_depth, time_in_ms);
+            result = search.timeSearch(pos, max_depth, time_in_ms);
         }
+        if (search.thread_id == 0) threads->finishMainThread();
 
         cv.notify_all();
     }
 }
 
-Threads::Threads(int num_threads) : is_stopped(true), tt() { resize(num_threads); }
+Threads::Threads(int num_threads)
+    : is_stopped(true),
+      node_pool(0),
+      tt(),
+      eval_cache_mb(EVAL_CACHE_DEFAULT_MB),
+      deterministic(false),
+      best_result{NULL_MOVE, 0, 0},
+      make_output(true),
+      parallel_mode(LAZY_SMP) {
+    resize(num_threads);
+}
 
 Threads::~Threads() {
     exitThreads();
@@ -44,9 +60,39 @@ Threads::~Threads() {
     }
 }
 
-void Threads::timeSearch(Position pos, U64 time) {
+/*
+Deterministic searches get a fresh SearchSync, and the private TTs are cleared so the search
+doesn't depend on what the previous one left there.
+*/
+void Threads::prepareSearch() {
     is_stopped.store(false);
 
+    // the main thread can finish before a helper has even started, which must not vote with the
+    // previous search's result or add the previous search's nodes to its info lines
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        workers[i]->result = SearchResult{NULL_MOVE, 0, 0};
+        workers[i]->search.counters.clear();
+    }
+
+    if (!deterministic) {
+        sync.reset();
+        return;
+    }
+
+    std::vector<std::vector<TTWrite>*> logs;
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        workers[i]->search.local_tt->clear();
+        logs.push_back(&workers[i]->search.tt_log);
+    }
+    sync = std::make_unique<SearchSync>(&tt, std::move(logs));
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        workers[i]->search.sync = sync.get();
+    }
+}
+
+void Threads::timeSearch(Position pos, U64 time) {
+    prepareSearch();
+
     for (int i = 0; i < static_cast<int>(workers.size()); i++) {
         std::lock_guard lock(workers[i]->mx);
         workers[i]->pos = pos;
@@ -59,15 +105,27 @@ void Threads::timeSearch(Position pos, U64 time) {
     }
 }
 
-// Currently only counts nodes locally per thread
+/*
+The node limit is for all threads together, they take nodes from node_pool as they go. Which
+thread gets which nodes depends on timing, so deterministic searches split the limit evenly
+between the threads up front instead.
+*/
 void Threads::nodeSearch(Position pos, U64 nodes) {
-    is_stopped.store(false);
+    prepareSearch();
+    node_pool.store(static_cast<int64_t>(nodes));
+    U64 num_threads = workers.size();
 
-    for (int i = 0; i <static_cast<int>(workers.size()); i++) {
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
         std::lock_guard lock(workers[i]->mx);
         workers[i]->pos = pos;
         workers[i]->node_search = true;
-        workers[i]->max_nodes = nodes;
+        if (deterministic) {
+            workers[i]->max_nodes = nodes / num_threads + (i == 0 ? nodes % num_threads : 0);
+            workers[i]->node_pool = nullptr;
+        } else {
+            workers[i]->max_nodes = nodes;
+            workers[i]->node_pool = &node_pool;
+        }
         workers[i]->max_depth = MAX_PLY;
         workers[i]->is_waiting = false;
         workers[i]->cv.notify_all();
@@ -76,6 +134,29 @@ void Threads::nodeSearch(Position pos, U64 nodes) {
 
 void Threads::infiniteSearch(Position pos) { timeSearch(pos, 999999999); }
 
+void Threads::depthSearch(Position pos, int depth) {
+    prepareSearch();
+
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        std::lock_guard lock(workers[i]->mx);
+        workers[i]->pos = pos;
+        workers[i]->node_search = false;
+        workers[i]->max_nodes = 0;
+        workers[i]->max_depth = depth;
+        workers[i]->time_in_ms = 999999999;
+        workers[i]->is_waiting = false;
+        workers[i]->cv.notify_all();
+    }
+}
+
+void Threads::setDeterministic(bool enabled) {
+    stop();
+    deterministic = enabled;
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        workers[i]->search.setDeterministic(enabled);
+    }
+}
+
 void Threads::newGame() {
     stop();
     tt.clear();
@@ -83,6 +164,25 @@ void Threads::newGame() {
     for (int i = 0; i < static_cast<int>(workers.size()); i++) {
         workers[i]->search.clearHistory();
     }
+    clearEvalCaches();
+}
+
+void Threads::setEvalCacheSize(size_t size_in_mb) {
+    stop();
+    eval_cache_mb = size_in_mb;
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        workers[i]->search.eval_cache.resize(eval_cache_mb);
+    }
+}
+
+// needed whenever the eval parameters change, as cached scores are then stale
+void Threads::clearEvalCaches() {
+    stop();
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        workers[i]->search.pawn_table.clear();
+        workers[i]->search.material_table.clear();
+        workers[i]->search.eval_cache.clear();
+    }
 }
 
 void Threads::resize(int num_threads) {
@@ -91,11 +191,18 @@ void Threads::resize(int num_threads) {
         delete workers[i];
     }
     workers.clear();
+    counters.clear();
     threads.clear();
+    tt.setThreads(num_threads);
 
     for (int i = 0; i < num_threads; i++) {
-        workers.emplace_back(new SearchWrapper(&tt, &is_stopped, [this]() { return getNodes(); }));
+        workers.emplace_back(new SearchWrapper(this, &tt, &is_stopped, &counters));
+        counters.push_back(&workers[i]->search.counters);
         workers[i]->search.thread_id = i;
+        workers[i]->search.eval_cache.resize(eval_cache_mb);
+        workers[i]->search.setDeterministic(deterministic);
+        workers[i]->search.make_output = make_output;
+        workers[i]->search.abdada = parallel_mode == ABDADA;
         threads.emplace_back(std::thread([this, i] { workers[i]->wait(); }));
     }
 
@@ -133,12 +240,53 @@ void Threads::exitThreads() {
     }
 }
 
+/*
+Stops the helpers, waits for them and picks the move to play from all the threads' results. A
+deterministic search isn't stopped early as that would depend on timing, the helpers stop at
+their next iteration barrier anyway.
+*/
+void Threads::finishMainThread() {
+    if (!deterministic) is_stopped.store(true);
+
+    std::vector<SearchResult> results{workers[0]->result};
+    for (int i = 1; i < static_cast<int>(workers.size()); i++) {
+        std::unique_lock lock(workers[i]->mx);
+        workers[i]->cv.wait(lock, [&] { return workers[i]->is_waiting; });
+        results.push_back(workers[i]->result);
+    }
+    best_result = voteBestResult(results);
+
+    if (make_output) std::cout << "bestmove " << moveToString(best_result.move) << std::endl;
+}
+
+SearchResult Threads::bestResult() { return best_result; }
+
+void Threads::setParallelMode(ParallelMode mode) {
+    stop();
+    parallel_mode = mode;
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        workers[i]->search.abdada = mode == ABDADA;
+    }
+}
+
+void Threads::setOutput(bool enabled) {
+    stop();
+    make_output = enabled;
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        workers[i]->search.make_output = enabled;
+    }
+}
+
 U64 Threads::getNodes() {
     U64 nodes = 0ULL;
-    for (const auto& w : workers) {
-        nodes += w->search.nodes_searched;
+    for (const SearchCounters* thread : counters) {
+        nodes += thread->nodes.load(std::memory_order_relaxed);
     }
     return nodes;
 }
 
+U64 Threads::getNodes(int thread) {
+    return counters[thread]->nodes.load(std::memory_order_relaxed);
+}
+
 }  // namespace Spotlight
@@ -11,9 +11,19 @@
 
 namespace Spotlight {
 
+/*
+LAZY_SMP: the threads share only the TT, with the helpers staggered over depths.
+ABDADA: every thread searches every iteration, and moves other threads are busy with are put
+off until the end of the move list (see Search::negaMax).
+*/
+enum ParallelMode { LAZY_SMP, ABDADA };
+
+class Threads;
+
 class SearchWrapper {
    public:
-    SearchWrapper(TT* _tt, std::atomic<bool>* _is_stopped, std::function<U64()> _getNodes);
+    SearchWrapper(Threads* _threads, TT* _tt, std::atomic<bool>* _is_stopped,
+                  const std::vector<const SearchCounters*>* _thread_counters);
     ~SearchWrapper(){};
 
     Search search;
@@ -23,14 +33,18 @@ class SearchWrapper {
 
     bool node_search;
     U64 max_nodes;
+    std::atomic<int64_t>* node_pool;
     int max_depth;
     U64 time_in_ms;
 
+    SearchResult result;
+
     bool is_waiting;
     bool exit_thread;
     void wait();
 
    private:
+    Threads* threads;
 };
 
 class Threads {
@@ -40,20 +54,48 @@ class Threads {
 
     void timeSearch(Position pos, U64 time);
     void nodeSearch(Position pos, U64 nodes);
+    void depthSearch(Position pos, int depth);
     void infiniteSearch(Position pos);
     void newGame();
+    void clearEvalCaches();
+    void setEvalCacheSize(size_t size_in_mb);
     void resize(int num_threads);
     void stop();
     void finishSearch();
     void exitThreads();
     U64 getNodes();
+    // nodes searched by one thread
+    U64 getNodes(int thread);
+    // the main thread's result from the last finished search
+    SearchResult bestResult();
+    void setDeterministic(bool enabled);
+    void setParallelMode(ParallelMode mode);
+    // info and bestmove output, on by default
+    void setOutput(bool enabled);
+    // run by the main thread once its own search is done
+    void finishMainThread();
 
     std::atomic<bool> is_stopped;
+    // nodes left in the current node limited search, shared by every thread
+    std::atomic<int64_t> node_pool;
     TT tt;
 
    private:
     std::vector<SearchWrapper*> workers;
+    // each worker's counters, summed for the node total
+    std::vector<const SearchCounters*> counters;
     std::vector<std::thread> threads;
+    // per-thread eval cache size, reapplied when the threads are recreated
+    size_t eval_cache_mb;
+
+    // see SearchSync. A new one is set up for every search
+    bool deterministic;
+    std::unique_ptr<SearchSync> sync;
+    void prepareSearch();
+
+    SearchResult best_result;
+    bool make_output;
+    ParallelMode parallel_mode;
 };
 
 }  // namespace Spotlight
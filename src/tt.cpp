@@ -1,39 +1,278 @@
 #include "tt.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace Spotlight {
 
-TTEntry::TTEntry() : hash16(0ULL), depth(0), best_move(0), score(0), flags(0) {}
+// lockless entries in shared memory need atomics that don't fall back to a per-process lock
+static_assert(std::atomic_ref<U64>::is_always_lock_free &&
+              std::atomic_ref<TTKey>::is_always_lock_free);
 
-TTEntry::TTEntry(U64 _z_key, int _depth, move16 _best_move, int _score, NodeType _node_type,
-                 int _s_eval, uint8_t _age, bool _is_pv)
-    : depth(_depth), best_move(_best_move), score(_score), s_eval(_s_eval), age(_age) {
-    flags = _node_type | (static_cast<uint8_t>(_is_pv) << 2);
-    hash16 = static_cast<uint16_t>(_z_key >> 48);
+static TTFileHeader makeHeader(U64 num_entries, uint8_t generation) {
+    TTFileHeader header{};
+    std::memcpy(header.magic, TT_FILE_MAGIC, sizeof(TT_FILE_MAGIC));
+    header.version = TT_FILE_VERSION;
+    header.bucket_size = sizeof(TTBucket);
+    header.num_entries = num_entries;
+    header.generation = generation;
+    header.key_bits = TT_KEY_BITS;
+    header.bucket_entries = BUCKET_SIZE;
+    header.stores_eval = TT_STORES_EVAL;
+    return header;
 }
 
-TT::TT() : hash_size(TT_SIZE), num_entries(NUM_ENTRIES), generation(0) {
-    hash_table.resize(NUM_ENTRIES);
-    clear();
+static bool validHeader(const TTFileHeader &header) {
+    return std::memcmp(header.magic, TT_FILE_MAGIC, sizeof(TT_FILE_MAGIC)) == 0 &&
+           header.version == TT_FILE_VERSION && header.bucket_size == sizeof(TTBucket) &&
+           header.key_bits == TT_KEY_BITS && header.bucket_entries == BUCKET_SIZE &&
+           header.stores_eval == TT_STORES_EVAL;
 }
 
-TT::TT(size_t size) : hash_size(size), num_entries(size / sizeof(TTBucket)), generation(0) {
-    hash_table.resize(num_entries);
-    clear();
+void TTStats::clear() {
+    probes = 0ULL;
+    hits = 0ULL;
+    false_hits = 0ULL;
+    for (auto &s : saves) {
+        s = 0ULL;
+    }
+}
+
+U64 TTEntry::pack(U64 z_key, int depth, move16 best_move, int score, NodeType node_type,
+                  int s_eval, uint8_t age, bool is_pv) {
+    U64 data = static_cast<U64>(best_move);
+    data |= static_cast<U64>(static_cast<uint16_t>(score)) << 16;
+    if constexpr (TT_STORES_EVAL) {
+        data |= static_cast<U64>(static_cast<uint16_t>(s_eval)) << 32;
+    } else {
+        data |= static_cast<U64>(extraKey(z_key)) << 32;
+    }
+    data |= static_cast<U64>(static_cast<uint8_t>(depth)) << 48;
+    data |= static_cast<U64>(node_type) << 56;
+    data |= static_cast<U64>(is_pv) << 58;
+    data |= static_cast<U64>(age & AGE_MASK) << 59;
+    return data;
+}
+
+TT::TT()
+    : hash_size(0),
+      num_entries(0),
+      hash_table(nullptr),
+      alloc_size(0),
+      mapping(nullptr),
+      mapping_size(0),
+      shared_name(),
+      shared_active(false),
+      large_pages(true),
+      large_pages_active(false),
+      num_threads(1),
+      generation(0) {
+    resize(TT_SIZE);
+}
+
+TT::TT(size_t size)
+    : hash_size(0),
+      num_entries(0),
+      hash_table(nullptr),
+      alloc_size(0),
+      mapping(nullptr),
+      mapping_size(0),
+      shared_name(),
+      shared_active(false),
+      large_pages(true),
+      large_pages_active(false),
+      num_threads(1),
+      generation(0) {
+    resize(size);
+}
+
+TT::~TT() { deallocate(); }
+
+/*
+Allocate the table. With large pages enabled the memory is aligned to 2MB and marked for
+transparent huge pages so that a large table costs far fewer TLB misses. If huge pages
+aren't available we still get an ordinary cache line aligned table.
+*/
+void TT::allocate(size_t size) {
+    large_pages_active = false;
+
+#if defined(__linux__)
+    if (large_pages && size >= LARGE_PAGE_SIZE) {
+        alloc_size = (size + LARGE_PAGE_SIZE - 1) / LARGE_PAGE_SIZE * LARGE_PAGE_SIZE;
+        void *mem = std::aligned_alloc(LARGE_PAGE_SIZE, alloc_size);
+        if (mem) {
+            large_pages_active = madvise(mem, alloc_size, MADV_HUGEPAGE) == 0;
+            hash_table = static_cast<TTBucket *>(mem);
+            return;
+        }
+    }
+#endif
+
+    alloc_size = (size + sizeof(TTBucket) - 1) / sizeof(TTBucket) * sizeof(TTBucket);
+    void *mem = std::aligned_alloc(alignof(TTBucket), alloc_size);
+    if (!mem) throw std::bad_alloc();
+    hash_table = static_cast<TTBucket *>(mem);
+}
+
+void TT::deallocate() {
+#if defined(__linux__)
+    if (mapping) {
+        munmap(mapping, mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+        hash_table = nullptr;
+        shared_active = false;
+    }
+#endif
+    std::free(hash_table);
+    hash_table = nullptr;
+    alloc_size = 0;
 }
 
 void TT::resize(size_t size) {
+    deallocate();
     hash_size = size;
     num_entries = size / sizeof(TTBucket);
-    hash_table.resize(num_entries);
+    if (!shared_name.empty() && attachShared()) return;
+    allocate(num_entries * sizeof(TTBucket));
+    clear();
 }
 
+/*
+Map the table from the named POSIX shared memory segment so several engine processes can share
+it. The first process creates the segment at our current size (zero filled, so it doesn't need
+clearing); later processes adopt whatever size the segment already has and keep its contents.
+Entries are lockless so concurrent writers from different processes are safe.
+*/
+bool TT::attachShared() {
+#if defined(__linux__)
+    size_t segment_size = TT_FILE_HEADER_SIZE + num_entries * sizeof(TTBucket);
+    bool created = true;
+
+    int fd = shm_open(shared_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        created = false;
+        fd = shm_open(shared_name.c_str(), O_RDWR, 0600);
+        if (fd < 0) return false;
+    }
+
+    if (created) {
+        if (ftruncate(fd, segment_size) != 0) {
+            close(fd);
+            shm_unlink(shared_name.c_str());
+            return false;
+        }
+    } else {
+        struct stat segment_stat;
+        if (fstat(fd, &segment_stat) != 0 ||
+            static_cast<size_t>(segment_stat.st_size) <= TT_FILE_HEADER_SIZE) {
+            close(fd);
+            return false;
+        }
+        segment_size = segment_stat.st_size;
+    }
+
+    void *mem = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) return false;
+
+    TTFileHeader *header = static_cast<TTFileHeader *>(mem);
+    if (created) {
+        *header = makeHeader(num_entries, generation);
+    } else if (!validHeader(*header) ||
+               segment_size != TT_FILE_HEADER_SIZE + header->num_entries * sizeof(TTBucket)) {
+        munmap(mem, segment_size);
+        return false;
+    }
+
+    mapping = mem;
+    mapping_size = segment_size;
+    hash_table = reinterpret_cast<TTBucket *>(static_cast<char *>(mem) + TT_FILE_HEADER_SIZE);
+    num_entries = header->num_entries;
+    hash_size = num_entries * sizeof(TTBucket);
+    large_pages_active = false;
+    shared_active = true;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Back the table with the named shared memory segment, or private memory if the name is empty
+void TT::setShared(const std::string &name) {
+    if (name == shared_name) return;
+    shared_name = name;
+    if (!shared_name.empty() && shared_name[0] != '/') shared_name = "/" + shared_name;
+    resize(hash_size);
+}
+
+bool TT::isShared() { return shared_active; }
+
+void TT::setLargePages(bool enabled) {
+    if (enabled == large_pages) return;
+    large_pages = enabled;
+    resize(hash_size);
+}
+
+bool TT::usingLargePages() { return large_pages_active; }
+
+void TT::setThreads(int threads) { num_threads = std::max(threads, 1); }
+
+/*
+Clear the table, splitting the memset for large tables across as many temporary threads as
+there are search threads. This only parallelises the clearing. The pages are first touched by
+those temporary threads rather than by the search workers, so on NUMA machines they are not
+placed on the nodes of the workers that go on to use them.
+
+The shared segment is never wiped, since other processes are still using it (and GUIs send
+ucinewgame at startup). Bumping the generation instead lets our old entries be replaced first.
+*/
 void TT::clear() {
-    for (auto &bucket : hash_table) {
-        for (auto &entry : bucket.entries) {
-            entry = TTEntry();
+    if (shared_active) {
+        nextGeneration();
+        stats.clear();
+        return;
+    }
+
+    size_t table_size = num_entries * sizeof(TTBucket);
+
+    if (num_threads == 1 || table_size < MIN_PARALLEL_CLEAR_SIZE) {
+        std::memset(static_cast<void *>(hash_table), 0, table_size);
+    } else {
+        std::vector<std::thread> threads;
+        U64 chunk = num_entries / num_threads;
+
+        for (int i = 0; i < num_threads; i++) {
+            U64 start = chunk * i;
+            U64 end = i == num_threads - 1 ? num_entries : start + chunk;
+            threads.emplace_back([this, start, end]() {
+                std::memset(static_cast<void *>(&hash_table[start]), 0,
+                            (end - start) * sizeof(TTBucket));
+            });
+        }
+
+        for (auto &t : threads) {
+            t.join();
         }
     }
+
     generation = 0;
+    stats.clear();
 }
 
 void TT::nextGeneration() { generation++; }
@@ -41,18 +280,20 @@ void TT::nextGeneration() { generation++; }
 // Fetches data from the TT. Returns true if there is a matching hash.
 bool TT::probe(U64 z_key, move16 &tt_move, NodeType &node_type, int &depth, int &score, int &s_eval,
                bool &tt_pv) {
-    uint16_t hash16 = static_cast<uint16_t>(z_key >> 48);
-
-    TTBucket *bucket = &hash_table[z_key % num_entries];
-
-    for (auto &entry : bucket->entries) {
-        if (entry.hash16 == hash16) {
-            tt_move = entry.best_move;
-            node_type = entry.getNodeType();
-            tt_pv = entry.getIsPV();
-            depth = entry.depth;
-            score = entry.score;
-            s_eval = entry.s_eval;
+    TTBucket *bucket = getBucket(z_key);
+
+    if constexpr (TRACK_TT_STATS) stats.probes.fetch_add(1, std::memory_order_relaxed);
+
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        U64 data = bucket->loadData(i);
+        if (TTEntry::matches(z_key, bucket->loadKey(i), data)) {
+            tt_move = TTEntry::getMove(data);
+            node_type = TTEntry::getNodeType(data);
+            tt_pv = TTEntry::getIsPV(data);
+            depth = TTEntry::getDepth(data);
+            score = TTEntry::getScore(data);
+            s_eval = TTEntry::getEval(data);
+            if constexpr (TRACK_TT_STATS) stats.hits.fetch_add(1, std::memory_order_relaxed);
             return true;
         }
     }
@@ -62,10 +303,11 @@ bool TT::probe(U64 z_key, move16 &tt_move, NodeType &node_type, int &depth, int
 // saves data to the TT
 void TT::save(U64 z_key, int depth, int ply, move16 best_move, int score, NodeType node_type,
               int s_eval, bool is_pv) {
-    int16_t worst_score = 32000;
-    uint16_t hash16 = static_cast<uint16_t>(z_key >> 48);
-    TTBucket *bucket = &hash_table[z_key % num_entries];
-    TTEntry *to_replace = &bucket->entries[0];
+    int worst_score = 32000;
+    TTBucket *bucket = getBucket(z_key);
+    int to_replace = 0;
+    U64 replace_data = bucket->loadData(0);
+    bool key_match = false;
 
     // adjust checkmate scores
     if (score > MATE_THRESHOLD) {
@@ -78,42 +320,298 @@ void TT::save(U64 z_key, int depth, int ply, move16 best_move, int score, NodeTy
     // lowest replacement score
     //
     // replacement score is depth - relative age * 8
-    for (auto &entry : bucket->entries) {
-        if (entry.hash16 == hash16) {
-            to_replace = &entry;
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        U64 data = bucket->loadData(i);
+        if (TTEntry::keyMatches(z_key, bucket->loadKey(i), data)) {
+            to_replace = i;
+            replace_data = data;
+            key_match = true;
             break;
         }
-        int replacement_score = entry.depth - (generation - entry.age) * 8;
+        int replacement_score =
+            TTEntry::getDepth(data) - ((generation - TTEntry::getAge(data)) & AGE_MASK) * 8;
         if (replacement_score < worst_score) {
             worst_score = replacement_score;
-            to_replace = &entry;
+            to_replace = i;
+            replace_data = data;
         }
     }
 
     // only replace a matching entry if the new depth is greater or
-    // the new node type is exact
-    if (to_replace->hash16 == hash16) {
-        if (depth >= to_replace->depth || node_type == EXACT_NODE) {
-            *to_replace =
-                TTEntry(z_key, depth, best_move, score, node_type, s_eval, generation, is_pv);
+    // the new node type is exact. ABDADA placeholders are always replaced
+    bool skip = key_match && TTEntry::getNodeType(replace_data) != NULL_NODE &&
+                depth < TTEntry::getDepth(replace_data) && node_type != EXACT_NODE;
+
+    if constexpr (TRACK_TT_STATS) {
+        ReplaceReason reason;
+        if (key_match) {
+            reason = skip ? SKIP_SAME_KEY : REPLACE_SAME_KEY;
+        } else if (TTEntry::getNodeType(replace_data) == NULL_NODE) {
+            reason = REPLACE_EMPTY;
+        } else if (TTEntry::getAge(replace_data) != (generation & AGE_MASK)) {
+            reason = REPLACE_OLD_GENERATION;
+        } else {
+            reason = REPLACE_LOWER_DEPTH;
         }
-        return;
+        stats.saves[reason].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (skip) return;
+
+    U64 data = TTEntry::pack(z_key, depth, best_move, score, node_type, s_eval, generation, is_pv);
+    // the threads still searching the position keep their claims
+    if (key_match && TTEntry::getAge(replace_data) == (generation & AGE_MASK)) {
+        data = TTEntry::setSearchers(data, TTEntry::getSearchers(replace_data));
     }
+    bucket->store(to_replace, z_key, data);
+}
 
-    *to_replace = TTEntry(z_key, depth, best_move, score, node_type, s_eval, generation, is_pv);
+void TT::prefetch(U64 z_key) { __builtin_prefetch(getBucket(z_key)); }
+
+// claims left over from an earlier search (by a save racing a removeSearcher) are ignored
+bool TT::isSearching(U64 z_key) {
+    TTBucket *bucket = getBucket(z_key);
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        U64 data = bucket->loadData(i);
+        if (TTEntry::keyMatches(z_key, bucket->loadKey(i), data)) {
+            return TTEntry::getSearchers(data) > 0 &&
+                   TTEntry::getAge(data) == (generation & AGE_MASK);
+        }
+    }
+    return false;
 }
 
-void TT::prefetch(U64 z_key) { __builtin_prefetch(&hash_table[z_key % num_entries]); }
+void TT::addSearcher(U64 z_key) { updateSearchers(z_key, 1); }
+
+void TT::removeSearcher(U64 z_key) { updateSearchers(z_key, -1); }
+
+/*
+Changes the searcher count of an entry with a compare and swap, retrying if another thread
+writes the entry first, so neither a save nor another thread's count change is lost. A position
+that isn't in the table yet gets a placeholder in the slot a save would pick, which the save at
+the end of its search then overwrites.
+*/
+void TT::updateSearchers(U64 z_key, int delta) {
+    TTBucket *bucket = getBucket(z_key);
+
+    while (true) {
+        int to_replace = 0;
+        U64 replace_data = 0ULL;
+        TTKey replace_key = 0;
+        int worst_score = 32000;
+        bool key_match = false;
+
+        for (int i = 0; i < BUCKET_SIZE; i++) {
+            U64 data = bucket->loadData(i);
+            TTKey key = bucket->loadKey(i);
+            if (TTEntry::keyMatches(z_key, key, data)) {
+                to_replace = i;
+                replace_data = data;
+                replace_key = key;
+                key_match = true;
+                break;
+            }
+            int replacement_score =
+                TTEntry::getDepth(data) - ((generation - TTEntry::getAge(data)) & AGE_MASK) * 8;
+            if (replacement_score < worst_score) {
+                worst_score = replacement_score;
+                to_replace = i;
+                replace_data = data;
+                replace_key = key;
+            }
+        }
+
+        U64 new_data;
+        if (key_match) {
+            int searchers = TTEntry::getSearchers(replace_data);
+            // a count from an earlier search is stale
+            if (TTEntry::getAge(replace_data) != (generation & AGE_MASK)) {
+                if (delta < 0) return;
+                searchers = 0;
+            }
+            searchers = std::clamp(searchers + delta, 0, MAX_SEARCHERS);
+            new_data = TTEntry::setSearchers(TTEntry::setAge(replace_data, generation), searchers);
+        } else if (delta > 0) {
+            new_data = TTEntry::setSearchers(
+                TTEntry::pack(z_key, 0, NULL_MOVE, 0, NULL_NODE, 0, generation, false), 1);
+        } else {
+            return;
+        }
+
+        if (new_data == replace_data ||
+            bucket->update(to_replace, z_key, replace_key, replace_data, new_data)) {
+            return;
+        }
+    }
+}
 
+/*
+Estimate the permille of entries used in the current generation. Buckets are sampled at even
+intervals across the whole table so the estimate isn't biased towards one region of it, and
+few enough of them are read that this is cheap to call on every info line.
+*/
 int TT::hashfull() {
-    int n = 0;
-    for (int i = 0; i < 1000; i++) {
-        for (auto &entry : hash_table[i].entries) {
-            n += entry.getNodeType() != NULL_NODE && entry.age == generation;
+    U64 samples = std::min(static_cast<U64>(HASHFULL_SAMPLES), num_entries);
+    U64 n = 0ULL;
+
+    for (U64 i = 0; i < samples; i++) {
+        TTBucket *bucket = &hash_table[i * num_entries / samples];
+        for (int k = 0; k < BUCKET_SIZE; k++) {
+            U64 data = bucket->loadData(k);
+            n += TTEntry::getNodeType(data) != NULL_NODE &&
+                 TTEntry::getAge(data) == (generation & AGE_MASK);
         }
     }
 
-    return n / BUCKET_SIZE;
+    return n * 1000 / (samples * BUCKET_SIZE);
+}
+
+// Exact permille of entries used in the current generation. Scans the whole table
+int TT::hashfullExact() {
+    return occupancyByAge()[0] * 1000 / (num_entries * BUCKET_SIZE);
+}
+
+size_t TT::size() { return hash_size; }
+
+// Count the entries in the whole table by how many generations old they are
+std::array<U64, AGE_MASK + 1> TT::occupancyByAge() {
+    std::array<U64, AGE_MASK + 1> occupancy{};
+
+    for (U64 i = 0; i < num_entries; i++) {
+        for (int k = 0; k < BUCKET_SIZE; k++) {
+            U64 data = hash_table[i].loadData(k);
+            if (TTEntry::getNodeType(data) != NULL_NODE) {
+                occupancy[(generation - TTEntry::getAge(data)) & AGE_MASK]++;
+            }
+        }
+    }
+
+    return occupancy;
+}
+
+void TT::printStats() {
+    auto percent = [](U64 n, U64 total) { return total ? n * 100.0 / total : 0.0; };
+
+    if constexpr (TRACK_TT_STATS) {
+        U64 probes = stats.probes.load();
+        U64 hits = stats.hits.load();
+        U64 false_hits = stats.false_hits.load();
+        U64 saves = 0ULL;
+        for (auto &s : stats.saves) {
+            saves += s.load();
+        }
+
+        std::cout << "info string tt probes " << probes << " hits " << hits << " ("
+                  << percent(hits, probes) << "%) false hits " << false_hits << " ("
+                  << percent(false_hits, hits) << "% of hits)\n";
+        std::cout << "info string tt saves " << saves << " empty "
+                  << stats.saves[REPLACE_EMPTY].load() << " same key "
+                  << stats.saves[REPLACE_SAME_KEY].load() << " skipped same key "
+                  << stats.saves[SKIP_SAME_KEY].load() << " older generation "
+                  << stats.saves[REPLACE_OLD_GENERATION].load() << " lower depth "
+                  << stats.saves[REPLACE_LOWER_DEPTH].load() << "\n";
+    } else {
+        std::cout << "info string tt probe and save counters disabled, build with make stats\n";
+    }
+
+    std::array<U64, AGE_MASK + 1> occupancy = occupancyByAge();
+    U64 total_entries = num_entries * BUCKET_SIZE;
+    U64 used = 0ULL;
+
+    std::cout << "info string tt occupancy by age";
+    for (int age = 0; age <= AGE_MASK; age++) {
+        used += occupancy[age];
+        if (occupancy[age]) {
+            std::cout << " " << age << ":" << percent(occupancy[age], total_entries) << "%";
+        }
+    }
+    std::cout << " total " << percent(used, total_entries) << "%" << std::endl;
+}
+
+// Write the table to a file with a header recording its size and generation
+bool TT::saveToFile(const std::string &path) {
+    std::ofstream out_file(path, std::ios::binary | std::ios::trunc);
+    if (!out_file.is_open()) return false;
+
+    char header_page[TT_FILE_HEADER_SIZE] = {};
+    TTFileHeader header = makeHeader(num_entries, generation);
+    std::memcpy(header_page, &header, sizeof(header));
+
+    out_file.write(header_page, TT_FILE_HEADER_SIZE);
+    out_file.write(reinterpret_cast<const char *>(hash_table), num_entries * sizeof(TTBucket));
+
+    return out_file.good();
+}
+
+/*
+Replace the table with one saved by saveToFile. On Linux the file is memory mapped (privately,
+so the file itself is never modified) and pages are only read in as the search touches them,
+which makes loading a large table nearly instant. Returns false and leaves the current table
+alone if the file is missing or doesn't match our layout, or while a shared segment is attached.
+*/
+bool TT::loadFromFile(const std::string &path) {
+    TTFileHeader header;
+
+    // replacing the mapping would silently detach us from the segment other processes use
+    if (shared_active) return false;
+
+#if defined(__linux__)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 ||
+        static_cast<size_t>(file_stat.st_size) <= TT_FILE_HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+
+    size_t file_size = file_stat.st_size;
+    void *mem = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) return false;
+
+    std::memcpy(&header, mem, sizeof(header));
+    if (!validHeader(header) ||
+        file_size != TT_FILE_HEADER_SIZE + header.num_entries * sizeof(TTBucket)) {
+        munmap(mem, file_size);
+        return false;
+    }
+
+    madvise(mem, file_size, MADV_RANDOM);
+
+    deallocate();
+    mapping = mem;
+    mapping_size = file_size;
+    hash_table = reinterpret_cast<TTBucket *>(static_cast<char *>(mem) + TT_FILE_HEADER_SIZE);
+    large_pages_active = false;
+#else
+    std::ifstream in_file(path, std::ios::binary);
+    if (!in_file.is_open()) return false;
+
+    char header_page[TT_FILE_HEADER_SIZE];
+    if (!in_file.read(header_page, TT_FILE_HEADER_SIZE)) return false;
+    std::memcpy(&header, header_page, sizeof(header));
+    if (!validHeader(header)) {
+        return false;
+    }
+
+    deallocate();
+    allocate(header.num_entries * sizeof(TTBucket));
+    if (!in_file.read(reinterpret_cast<char *>(hash_table),
+                      header.num_entries * sizeof(TTBucket))) {
+        num_entries = header.num_entries;
+        hash_size = num_entries * sizeof(TTBucket);
+        clear();
+        return false;
+    }
+#endif
+
+    num_entries = header.num_entries;
+    hash_size = num_entries * sizeof(TTBucket);
+    generation = header.generation;
+
+    return true;
 }
 
 }  // namespace Spotlight
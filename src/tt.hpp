@@ -1,6 +1,9 @@
 #pragma once
 
-#include <vector>
+#include <array>
+#include <atomic>
+#include <string>
+#include <type_traits>
 
 #include "move.hpp"
 #include "types.hpp"
@@ -11,43 +14,222 @@ const size_t TT_SIZE = 1024 * 1024 * 16;
 const int MAX_PLY = 100;
 const int MATE_SCORE = 30000;
 const int MATE_THRESHOLD = MATE_SCORE - MAX_PLY;
-const int BUCKET_SIZE = 3;
+const int AGE_BITS = 3;
+const uint8_t AGE_MASK = (1 << AGE_BITS) - 1;
+// ABDADA searcher counts saturate here, they only have two bits
+const int MAX_SEARCHERS = 3;
 enum NodeType : uint8_t { NULL_NODE, EXACT_NODE, LOWER_BOUND_NODE, UPPER_BOUND_NODE };
 
+/*
+TT layout, chosen at build time (see make bench-layouts):
+
+TT_KEY_BITS     width of the per-entry verification key, 16 or 32
+TT_STORE_EVAL   when 0 the static eval isn't stored and its 16 bits are used as extra key bits
+TT_BUCKET_SIZE  entries per bucket. defaults to as many as fit in one cache line
+*/
+#ifndef TT_KEY_BITS
+#define TT_KEY_BITS 16
+#endif
+
+#ifndef TT_STORE_EVAL
+#define TT_STORE_EVAL 1
+#endif
+
+static_assert(TT_KEY_BITS == 16 || TT_KEY_BITS == 32);
+
+using TTKey = std::conditional_t<TT_KEY_BITS == 32, uint32_t, uint16_t>;
+constexpr bool TT_STORES_EVAL = TT_STORE_EVAL;
+
+#ifndef TT_BUCKET_SIZE
+#define TT_BUCKET_SIZE (60 / (sizeof(U64) + sizeof(TTKey)))
+#endif
+
+const int BUCKET_SIZE = TT_BUCKET_SIZE;
+
+// returned as the static eval from probes when the layout doesn't store it
+const int NO_EVAL = -32001;
+
+/*
+Each TT entry is all of its data packed into one 64-bit word plus a 16 or 32-bit key. The key is
+the low bits of the zobrist key (the high bits pick the bucket) xor'd with a fold of the data,
+so it doubles as a checksum. Both parts are loaded and stored atomically (relaxed), so the data
+word can never mix fields from different writes, and when two threads write the same entry at
+once a reader that sees a key from one write and data from another fails the key check (the
+same as any other hash collision).
+
+data layout:
+bits 0-15   best move
+bits 16-31  score
+bits 32-47  static eval, or more key bits if TT_STORE_EVAL is 0
+bits 48-55  depth
+bits 56-57  node type
+bit  58     is pv
+bits 59-61  age
+bits 62-63  threads searching the position (ABDADA), see TT::addSearcher
+
+An entry with a key but a NULL_NODE type is a placeholder that only carries a searcher count.
+Probes never return it and saves to the same position overwrite it.
+*/
 class TTEntry {
    public:
-    TTEntry();
-    TTEntry(U64 _z_key, int _depth, move16 _best_move, int _score, NodeType _node_type, int _s_eval,
-            uint8_t _age, bool _is_pv);
+    static U64 pack(U64 z_key, int depth, move16 best_move, int score, NodeType node_type,
+                    int s_eval, uint8_t age, bool is_pv);
 
-    inline NodeType getNodeType() { return static_cast<NodeType>(flags & 0b11); }
+    static inline TTKey makeKey(U64 z_key, U64 data) {
+        if constexpr (TT_KEY_BITS == 32) {
+            return static_cast<uint32_t>(z_key) ^ static_cast<uint32_t>(data ^ (data >> 32));
+        } else {
+            return static_cast<uint16_t>(z_key) ^
+                   static_cast<uint16_t>(data ^ (data >> 16) ^ (data >> 32) ^ (data >> 48));
+        }
+    }
 
-    inline bool getIsPV() { return static_cast<bool>(flags >> 2 & 1); }
+    // the extra key bits stored in place of the static eval
+    static inline uint16_t extraKey(U64 z_key) {
+        return static_cast<uint16_t>(z_key >> TT_KEY_BITS);
+    }
 
-    uint16_t hash16;
-    int16_t depth;
-    move16 best_move;
-    int16_t score;
-    int16_t s_eval;
-    uint8_t flags;
-    uint8_t age;
+    // true for placeholders as well as real entries
+    static inline bool keyMatches(U64 z_key, TTKey key, U64 data) {
+        return key == makeKey(z_key, data) &&
+               (TT_STORES_EVAL || static_cast<uint16_t>(data >> 32) == extraKey(z_key));
+    }
 
-   private:
+    static inline bool matches(U64 z_key, TTKey key, U64 data) {
+        return keyMatches(z_key, key, data) && getNodeType(data) != NULL_NODE;
+    }
+
+    static inline move16 getMove(U64 data) { return static_cast<move16>(data); }
+    static inline int getScore(U64 data) { return static_cast<int16_t>(data >> 16); }
+    static inline int getEval(U64 data) {
+        return TT_STORES_EVAL ? static_cast<int16_t>(data >> 32) : NO_EVAL;
+    }
+    static inline int getDepth(U64 data) { return static_cast<int8_t>(data >> 48); }
+    static inline NodeType getNodeType(U64 data) {
+        return static_cast<NodeType>((data >> 56) & 0b11);
+    }
+    static inline bool getIsPV(U64 data) { return static_cast<bool>((data >> 58) & 1); }
+    static inline uint8_t getAge(U64 data) { return static_cast<uint8_t>(data >> 59) & AGE_MASK; }
+    static inline U64 setAge(U64 data, uint8_t age) {
+        return (data & ~(static_cast<U64>(AGE_MASK) << 59)) |
+               static_cast<U64>(age & AGE_MASK) << 59;
+    }
+    static inline int getSearchers(U64 data) { return static_cast<int>(data >> 62); }
+    static inline U64 setSearchers(U64 data, int searchers) {
+        return (data & ~(3ULL << 62)) | static_cast<U64>(searchers) << 62;
+    }
 };
 
-struct TTBucket {
-    TTEntry entries[BUCKET_SIZE];
+/*
+Buckets hold the data words of all entries followed by their keys. With the default bucket size
+a bucket is exactly one cache line, so a probe only ever touches a single line of memory.
+Larger buckets are padded to a whole number of lines.
+*/
+template <typename Key, int Size>
+struct alignas(64) TTBucketLayout {
+    U64 data[Size];
+    Key keys[Size];
+
+    inline U64 loadData(int i) {
+        return std::atomic_ref<U64>(data[i]).load(std::memory_order_relaxed);
+    }
+
+    inline Key loadKey(int i) {
+        return std::atomic_ref<Key>(keys[i]).load(std::memory_order_relaxed);
+    }
+
+    inline void store(int i, U64 z_key, U64 new_data) {
+        std::atomic_ref<U64>(data[i]).store(new_data, std::memory_order_relaxed);
+        std::atomic_ref<Key>(keys[i]).store(TTEntry::makeKey(z_key, new_data),
+                                            std::memory_order_relaxed);
+    }
+
+    /*
+    Replaces the entry only if its data word is still old_data. The key is then swapped from
+    old_key the same way, so a save that lands in between keeps its own key rather than ours.
+    */
+    inline bool update(int i, U64 z_key, Key old_key, U64 old_data, U64 new_data) {
+        if (!std::atomic_ref<U64>(data[i]).compare_exchange_strong(old_data, new_data,
+                                                                   std::memory_order_relaxed)) {
+            return false;
+        }
+        std::atomic_ref<Key>(keys[i]).compare_exchange_strong(
+            old_key, TTEntry::makeKey(z_key, new_data), std::memory_order_relaxed);
+        return true;
+    }
 };
 
+using TTBucket = TTBucketLayout<TTKey, BUCKET_SIZE>;
+
+static_assert(sizeof(TTBucket) % 64 == 0);
+
 const int NUM_ENTRIES = TT_SIZE / sizeof(TTBucket);
+const size_t LARGE_PAGE_SIZE = 2 * 1024 * 1024;
+// number of buckets sampled, spread evenly over the table, to estimate hashfull
+const int HASHFULL_SAMPLES = 200;
+// tables smaller than this are cleared on the calling thread
+const size_t MIN_PARALLEL_CLEAR_SIZE = 32 * 1024 * 1024;
+
+/*
+TT snapshot files and shared memory segments start with this header. The table starts one page
+in so it is page aligned when mapped
+*/
+const char TT_FILE_MAGIC[8] = {'S', 'P', 'O', 'T', 'L', 'T', 'T', '\0'};
+const uint32_t TT_FILE_VERSION = 4;
+const size_t TT_FILE_HEADER_SIZE = 4096;
+
+struct TTFileHeader {
+    char magic[8];
+    uint32_t version;
+    // bytes per bucket, so that files written with a different layout are rejected
+    uint32_t bucket_size;
+    U64 num_entries;
+    uint8_t generation;
+    uint8_t key_bits;
+    uint8_t bucket_entries;
+    uint8_t stores_eval;
+};
+
+static_assert(sizeof(TTFileHeader) <= TT_FILE_HEADER_SIZE);
+
+// Build with -DTT_STATS (make stats) to count probes, hits and replacements
+#ifdef TT_STATS
+constexpr bool TRACK_TT_STATS = true;
+#else
+constexpr bool TRACK_TT_STATS = false;
+#endif
+
+enum ReplaceReason : int {
+    REPLACE_EMPTY,
+    REPLACE_SAME_KEY,
+    SKIP_SAME_KEY,
+    REPLACE_OLD_GENERATION,
+    REPLACE_LOWER_DEPTH,
+    NUM_REPLACE_REASONS
+};
+
+struct TTStats {
+    std::atomic<U64> probes;
+    std::atomic<U64> hits;
+    // hits whose move turned out to be illegal, so must have come from another position
+    std::atomic<U64> false_hits;
+    std::atomic<U64> saves[NUM_REPLACE_REASONS];
+
+    void clear();
+};
 
 class TT {
    public:
     TT();
     TT(size_t size);
-    ~TT(){};
+    ~TT();
+    TT(const TT &) = delete;
+    TT &operator=(const TT &) = delete;
 
     void resize(size_t size);
+    void setThreads(int threads);
+    void setLargePages(bool enabled);
+    bool usingLargePages();
     void clear();
     void nextGeneration();
     bool probe(U64 z_key, move16 &tt_move, NodeType &node_type, int &depth, int &score, int &s_eval,
@@ -55,12 +237,53 @@ class TT {
     void save(U64 z_key, int depth, int ply, move16 best_move, int score, NodeType node_type,
               int s_eval, bool is_pv);
     void prefetch(U64 z_key);
+    // ABDADA: whether any thread is searching the position in the current search
+    bool isSearching(U64 z_key);
+    void addSearcher(U64 z_key);
+    void removeSearcher(U64 z_key);
     int hashfull();
+    int hashfullExact();
+    bool saveToFile(const std::string &path);
+    bool loadFromFile(const std::string &path);
+    void setShared(const std::string &name);
+    bool isShared();
+    size_t size();
+    std::array<U64, AGE_MASK + 1> occupancyByAge();
+    void printStats();
+
+    inline void recordFalseHit() {
+        if constexpr (TRACK_TT_STATS) stats.false_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    TTStats stats;
 
    private:
+    // maps a key onto [0, num_entries) using the high bits of a 128-bit multiply rather
+    // than a 64-bit modulo. works for any table size.
+    inline TTBucket *getBucket(U64 z_key) {
+        return &hash_table[static_cast<U64>(
+            (static_cast<unsigned __int128>(z_key) * static_cast<unsigned __int128>(num_entries)) >>
+            64)];
+    }
+
+    void updateSearchers(U64 z_key, int delta);
+    void allocate(size_t size);
+    void deallocate();
+    bool attachShared();
+
     size_t hash_size;
     U64 num_entries;
-    std::vector<TTBucket> hash_table;
+    TTBucket *hash_table;
+    size_t alloc_size;
+    // set when the table lives in a file mapping rather than allocated memory
+    void *mapping;
+    size_t mapping_size;
+    // name of the POSIX shared memory segment backing the table, if any
+    std::string shared_name;
+    bool shared_active;
+    bool large_pages;
+    bool large_pages_active;
+    int num_threads;
     uint8_t generation;
 };
 
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -46,56 +47,22 @@ Tuner::Tuner() : weights{}, gradient{} {
 
         pos.readFen(fen);
 
-        /*
-        To make things easier I just copied my eval code to here. If I make my eval more complex
-        I will have to change this.
-        */
-
-        int early_eval = 0;
-        int late_eval = 0;
-
-        int game_phase = 0;
-        std::array<std::array<int, 2>, NUM_PARAMS / 2> coeffs{};
-
-        for (int i = 0; i < 64; i++) {
-            Piece piece = pos.at(static_cast<Square>(i));
-
-            if (piece != NO_PIECE) {
-                game_phase += phase_values[piece % 6];
-                int coeff_idx;
-                if (piece < BLACK_PAWN) {
-                    coeff_idx = getPieceType(piece) * 64 + (i ^ 56);
-                    coeffs[coeff_idx][WHITE]++;
-                    early_eval += piece_values[0][getPieceType(piece)] +
-                                  piece_square_tables[getPieceType(piece)][0][i ^ 56];
-                    late_eval += piece_values[1][getPieceType(piece)] +
-                                 piece_square_tables[getPieceType(piece)][1][i ^ 56];
-                } else {
-                    coeff_idx = getPieceType(piece) * 64 + i;
-                    coeffs[coeff_idx][BLACK]++;
-                    early_eval -= piece_values[0][getPieceType(piece)] +
-                                  piece_square_tables[getPieceType(piece)][0][i];
-                    late_eval -= piece_values[1][getPieceType(piece)] +
-                                 piece_square_tables[getPieceType(piece)][1][i];
-                }
-            }
-        }
-
-        int total_eval =
-            (early_eval * game_phase + late_eval * (TOTAL_PHASE - game_phase)) / TOTAL_PHASE;
+        // the traced eval gives the per-term coefficients, from white's point of view
+        EvalTrace trace;
+        evalFromScratch(pos, trace);
 
         entry.s_eval = eval(pos);
         if (pos.side_to_move == BLACK) {
             entry.s_eval *= -1;
         }
-        entry.d_eval = static_cast<double>(total_eval);
-        entry.phase = game_phase;
+        entry.d_eval = static_cast<double>(entry.s_eval);
+        entry.phase = trace.phase;
 
-        for (int i = 0; i < NUM_PARAMS / 2; i++) {
-            if (coeffs[i][WHITE] - coeffs[i][BLACK] != 0) {
+        for (int i = 0; i < NUM_EVAL_TERMS; i++) {
+            if (trace.coeffs[i][WHITE] - trace.coeffs[i][BLACK] != 0) {
                 CoeffData data;
-                data.wcoef = coeffs[i][WHITE];
-                data.bcoef = coeffs[i][BLACK];
+                data.wcoef = trace.coeffs[i][WHITE];
+                data.bcoef = trace.coeffs[i][BLACK];
                 data.index = i;
                 entry.active_coeffs.push_back(data);
             }
@@ -196,7 +163,7 @@ void Tuner::calculateGradient() {
 }
 
 void Tuner::updateWeights(double lr) {
-    for (int i = 0; i < PSQ_ARRAY_SIZE; i++) {
+    for (int i = 0; i < NUM_EVAL_TERMS; i++) {
         weights[i][0] -= gradient[i][0] * lr;
         weights[i][1] -= gradient[i][1] * lr;
     }
@@ -204,14 +171,14 @@ void Tuner::updateWeights(double lr) {
 
 void Tuner::run() {
     k_param = computeOptimalK();
-    std::array<std::array<double, 2>, PSQ_ARRAY_SIZE> ada_grad{};
+    std::array<std::array<double, 2>, NUM_EVAL_TERMS> ada_grad{};
 
     std::cout << "Tuning\n";
     for (int epoch = 0; epoch < MAX_EPOCHS; epoch++) {
         zeroGrad();
         forward();
         calculateGradient();
-        for (int i = 0; i < PSQ_ARRAY_SIZE; i++) {
+        for (int i = 0; i < NUM_EVAL_TERMS; i++) {
             ada_grad[i][0] += pow(2.0 * gradient[i][0] / NUM_PARAMS, 2.0);
             ada_grad[i][1] += pow(2.0 * gradient[i][1] / NUM_PARAMS, 2.0);
 
@@ -228,70 +195,66 @@ void Tuner::run() {
     }
 }
 
-void Tuner::printWeights() {
+// the EvalParams entry a trace term refers to
+static Score &termParam(EvalParams &params, int term) {
+    if (term < TERM_PASSED_PAWN) {
+        return params.piece_square_tables[(term - TERM_PSQT) / 64][(term - TERM_PSQT) % 64];
+    }
+    if (term < TERM_ISOLATED_PAWN) return params.passed_pawn[term - TERM_PASSED_PAWN];
+    if (term == TERM_ISOLATED_PAWN) return params.isolated_pawn;
+    if (term == TERM_DOUBLED_PAWN) return params.doubled_pawn;
+    return params.bishop_pair;
+}
+
+EvalParams Tuner::tunedParams() {
+    EvalParams params = *eval_params;
+    for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+        termParam(params, term) += S(std::round(weights[term][0]), std::round(weights[term][1]));
+    }
+    return params;
+}
+
+// tuned terms formatted the way they are written in eval.hpp
+void Tuner::writeWeights(std::ostream &out) {
+    EvalParams params = tunedParams();
+    auto format = [](Score score) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "S(%4d,%4d)", mgScore(score), egScore(score));
+        return std::string(buffer);
+    };
+
     for (int piece = PAWN; piece <= KING; piece++) {
-        std::cout << "{\n";
-        for (int phase = 0; phase <= 1; phase++) {
-            std::cout << "    {\n";
-            for (int rank = 0; rank < 8; rank++) {
-                std::cout << "       ";
-                for (int file = 0; file < 8; file++) {
-                    int sq = rank * 8 + file;
-                    int idx = piece * 64 + sq;
-                    int w = std::round(weights[idx][phase]) + piece_square_tables[piece][phase][sq];
-                    int spaces = 3;
-                    if (w != 0) {
-                        spaces = 3 - floor(log10(abs(w)));
-                        if (w < 0) {
-                            spaces -= 1;
-                        }
-                    }
-                    for (int i = 0; i < spaces; i++) {
-                        std::cout << " ";
-                    }
-                    std::cout << w << ",";
-                }
-                std::cout << "\n";
+        out << "    {\n";
+        for (int rank = 0; rank < 8; rank++) {
+            out << "       ";
+            for (int file = 0; file < 8; file++) {
+                out << " " << format(params.piece_square_tables[piece][rank * 8 + file]) << ",";
             }
-            std::cout << "    },\n";
+            out << "\n";
         }
-        std::cout << "},\n";
+        out << "    },\n";
+    }
+
+    out << "passed_pawn:";
+    for (Score score : params.passed_pawn) {
+        out << " " << format(score) << ",";
     }
+    out << "\nisolated_pawn: " << format(params.isolated_pawn) << "\n";
+    out << "doubled_pawn: " << format(params.doubled_pawn) << "\n";
+    out << "bishop_pair: " << format(params.bishop_pair) << "\n";
 }
 
+void Tuner::printWeights() { writeWeights(std::cout); }
+
 void Tuner::outputToFile() {
     std::ofstream out_file;
     out_file.open(TUNING_PARAMS_FILE);
     if (!out_file.is_open()) return;
-    for (int piece = PAWN; piece <= KING; piece++) {
-        out_file << "{\n";
-        for (int phase = 0; phase <= 1; phase++) {
-            out_file << "    {\n";
-            for (int rank = 0; rank < 8; rank++) {
-                out_file << "       ";
-                for (int file = 0; file < 8; file++) {
-                    int sq = rank * 8 + file;
-                    int idx = piece * 64 + sq;
-                    int w = std::round(weights[idx][phase]) + piece_square_tables[piece][phase][sq];
-                    int spaces = 3;
-                    if (w != 0) {
-                        spaces = 3 - floor(log10(abs(w)));
-                        if (w < 0) {
-                            spaces -= 1;
-                        }
-                    }
-                    for (int i = 0; i < spaces; i++) {
-                        out_file << " ";
-                    }
-                    out_file << w << ",";
-                }
-                out_file << "\n";
-            }
-            out_file << "    },\n";
-        }
-        out_file << "},\n";
-    }
+    writeWeights(out_file);
     out_file.close();
+
+    // the same params as a binary file the engine can load with EvalFile
+    writeEvalFile(TUNING_EVAL_FILE, tunedParams());
 }
 
 }  // namespace Spotlight
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <array>
+#include <ostream>
 #include <string>
 #include <vector>
 
+#include "eval.hpp"
+#include "evaltrace.hpp"
+
 /*
 Tuning implementation from Andrew Grant's tuning paper:
 https://github.com/AndyGrant/Ethereal/blob/master/Tuning.pdf
@@ -12,14 +16,14 @@ https://github.com/AndyGrant/Ethereal/blob/master/Tuning.pdf
 namespace Spotlight {
 
 const int MAX_POSITIONS = 5000000;
-const int NUM_PARAMS = 64 * 6 * 2;
-const int PSQ_ARRAY_SIZE = NUM_PARAMS / 2;
+const int NUM_PARAMS = NUM_EVAL_TERMS * 2;
 const int K_PRECISION = 10;
 const int MAX_EPOCHS = 50000;
 const int REPORT_INTERVAL = 200;
 const double LEARNING_RATE = 0.06;
 const std::string TUNING_FILE = "./tune.txt";
 const std::string TUNING_PARAMS_FILE = "./piece_squares.txt";
+const std::string TUNING_EVAL_FILE = "./spotlight.eval";
 
 struct CoeffData {
     int wcoef, bcoef;
@@ -48,12 +52,14 @@ class Tuner {
     void updateWeights(double lr);
     void printWeights();
     void outputToFile();
+    void writeWeights(std::ostream &out);
+    EvalParams tunedParams();
 
     void forward();
     void run();
     std::vector<PositionData> t_positions;
-    std::array<std::array<double, 2>, PSQ_ARRAY_SIZE> weights;
-    std::array<std::array<double, 2>, PSQ_ARRAY_SIZE> gradient;
+    std::array<std::array<double, 2>, NUM_EVAL_TERMS> weights;
+    std::array<std::array<double, 2>, NUM_EVAL_TERMS> gradient;
 
     double k_param;
 
@@ -8,6 +8,28 @@ using U64 = std::uint64_t;
 using BitBoard = std::uint64_t;
 using move16 = std::uint16_t;
 
+/*
+Midgame and endgame values packed into one integer, eg in the high 16 bits and mg in the low 16
+bits, so both phases are added or subtracted with a single instruction. The low half is signed,
+so getting eg back out has to undo the borrow it causes.
+*/
+using Score = std::int32_t;
+
+constexpr Score S(int mg, int eg) {
+    return static_cast<Score>(static_cast<std::uint32_t>(eg) << 16) + mg;
+}
+
+constexpr int mgScore(Score score) {
+    return static_cast<std::int16_t>(static_cast<std::uint16_t>(static_cast<std::uint32_t>(score)));
+}
+
+constexpr int egScore(Score score) {
+    return static_cast<std::int16_t>(
+        static_cast<std::uint16_t>((static_cast<std::uint32_t>(score) + 0x8000) >> 16));
+}
+
+static_assert(mgScore(S(-5, 7) + S(3, -20)) == -2 && egScore(S(-5, 7) + S(3, -20)) == -13);
+
 enum Color : uint8_t { WHITE, BLACK };
 
 enum GenType : int { CAPTURES_AND_PROMOTIONS, QUIET, LEGAL };
@@ -3,11 +3,13 @@
 #include <chrono>
 #include <iostream>
 
+#include "eval.hpp"
+#include "nnue.hpp"
 #include "test.hpp"
 
 namespace Spotlight {
 
-UCI::UCI() :  position(), search_threads(1) {}
+UCI::UCI() : position(), search_threads(1), use_nnue(false) {}
 
 void UCI::loop() {
     std::string line;
@@ -26,6 +28,16 @@ void UCI::loop() {
             std::cout << "id author github.com/jksnook\n";
             std::cout << "option name Threads type spin default 1 min 1 max 64\n";
             std::cout << "option name Hash type spin default 16 min 1 max 4096\n";
+            std::cout << "option name LargePages type check default true\n";
+            std::cout << "option name SharedHash type string default <empty>\n";
+            std::cout << "option name UseNNUE type check default false\n";
+            std::cout << "option name NNUEFile type string default <empty>\n";
+            std::cout << "option name EvalFile type string default <empty>\n";
+            std::cout << "option name EvalCache type spin default " << EVAL_CACHE_DEFAULT_MB
+                      << " min 0 max 256\n";
+            std::cout << "option name Deterministic type check default false\n";
+            std::cout << "option name ParallelSearch type combo default LazySMP var LazySMP var "
+                         "ABDADA\n";
             std::cout << "uciok\n";
         } else if (token == "ucinewgame") {
             search_threads.newGame();
@@ -51,6 +63,33 @@ void UCI::loop() {
             parseSetOption(commands);
         } else if (token == "stop") {
             search_threads.stop();
+        } else if (token == "hashfull") {
+            std::cout << "info string hashfull sampled " << search_threads.tt.hashfull()
+                      << " exact " << search_threads.tt.hashfullExact() << std::endl;
+        } else if (token == "ttstats") {
+            search_threads.tt.printStats();
+        } else if (token == "savehash") {
+            std::string path;
+            std::getline(commands >> std::ws, path);
+            search_threads.stop();
+            if (search_threads.tt.saveToFile(path)) {
+                std::cout << "info string saved hash to " << path << std::endl;
+            } else {
+                std::cout << "info string failed to save hash to " << path << std::endl;
+            }
+        } else if (token == "loadhash") {
+            std::string path;
+            std::getline(commands >> std::ws, path);
+            search_threads.stop();
+            if (search_threads.tt.isShared()) {
+                std::cout << "info string loadhash is not available with a shared hash"
+                          << std::endl;
+            } else if (search_threads.tt.loadFromFile(path)) {
+                std::cout << "info string loaded " << search_threads.tt.size() / (1024 * 1024)
+                          << "MB hash from " << path << std::endl;
+            } else {
+                std::cout << "info string failed to load hash from " << path << std::endl;
+            }
         }
     }
 }
@@ -178,6 +217,12 @@ void UCI::parseGo(std::istringstream& commands) {
         U64 nps = node_count / duration.count();
 
         std::cout << node_count << " nodes searched in " << duration.count() << "s " << nps << " nps\n";
+    } else if (token == "depth") {
+        token.clear();
+        commands >> token;
+        int depth = stoi(token);
+        if (depth < 1) return;
+        search_threads.depthSearch(position, depth);
     } else if (token == "infinite") {
         search_threads.infiniteSearch(position);
     } else if (token == "movetime") {
@@ -214,7 +259,100 @@ void UCI::parseSetOption(std::istringstream& commands) {
         size_t size = stoi(token);
         if (size > 4096 || size < 1) return;
         size *= 1024 * 1024;
+        search_threads.stop();
         search_threads.tt.resize(size);
+        if (search_threads.tt.isShared()) {
+            std::cout << "info string Hash is ignored while using a shared hash" << std::endl;
+        }
+    } else if (token == "EvalCache") {
+        token.clear();
+        commands >> token;
+        if (token != "value") return;
+        token.clear();
+        commands >> token;
+        int size = stoi(token);
+        if (size > 256 || size < 0) return;
+        search_threads.setEvalCacheSize(size);
+    } else if (token == "LargePages") {
+        token.clear();
+        commands >> token;
+        if (token != "value") return;
+        token.clear();
+        commands >> token;
+        search_threads.stop();
+        search_threads.tt.setLargePages(token == "true");
+    } else if (token == "SharedHash") {
+        token.clear();
+        commands >> token;
+        if (token != "value") return;
+        std::string name;
+        std::getline(commands >> std::ws, name);
+        if (name == "<empty>") name.clear();
+        search_threads.stop();
+        search_threads.tt.setShared(name);
+        if (!name.empty() && !search_threads.tt.isShared()) {
+            std::cout << "info string failed to attach shared hash " << name << std::endl;
+        }
+    } else if (token == "UseNNUE") {
+        token.clear();
+        commands >> token;
+        if (token != "value") return;
+        token.clear();
+        commands >> token;
+        search_threads.stop();
+        use_nnue = token == "true";
+        nnue_enabled = use_nnue && network_loaded;
+        if (use_nnue && !network_loaded) {
+            std::cout << "info string no network loaded, using the PSQT eval" << std::endl;
+        }
+        search_threads.clearEvalCaches();
+        position.refreshAccumulators();
+    } else if (token == "NNUEFile") {
+        token.clear();
+        commands >> token;
+        if (token != "value") return;
+        std::string path;
+        std::getline(commands >> std::ws, path);
+        if (path == "<empty>") return;
+        search_threads.stop();
+        if (loadNetwork(path)) {
+            std::cout << "info string loaded network " << path << std::endl;
+        } else {
+            std::cout << "info string failed to load network " << path << std::endl;
+        }
+        nnue_enabled = use_nnue && network_loaded;
+        search_threads.clearEvalCaches();
+        position.refreshAccumulators();
+    } else if (token == "EvalFile") {
+        token.clear();
+        commands >> token;
+        if (token != "value") return;
+        std::string path;
+        std::getline(commands >> std::ws, path);
+        search_threads.stop();
+        if (path == "<empty>") {
+            useDefaultEvalParams();
+        } else if (loadEvalFile(path)) {
+            std::cout << "info string loaded eval params " << path << std::endl;
+        } else {
+            std::cout << "info string failed to load eval params " << path << std::endl;
+        }
+        search_threads.clearEvalCaches();
+        position.refreshScores();
+    } else if (token == "Deterministic") {
+        token.clear();
+        commands >> token;
+        if (token != "value") return;
+        token.clear();
+        commands >> token;
+        search_threads.setDeterministic(token == "true");
+    } else if (token == "ParallelSearch") {
+        token.clear();
+        commands >> token;
+        if (token != "value") return;
+        token.clear();
+        commands >> token;
+        search_threads.setParallelMode(token == "ABDADA" ? ABDADA : LAZY_SMP);
     }
 }
 
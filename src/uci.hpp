@@ -23,6 +23,8 @@ class UCI {
    private:
     Position position;
     Threads search_threads;
+    // UseNNUE as set by the GUI, only takes effect once a network is loaded
+    bool use_nnue;
 };
 
 }  // namespace Spotlight
\ No newline at end of file